@@ -0,0 +1,123 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#ifndef AGGREGATECONDUCTANCE_HXX
+#define AGGREGATECONDUCTANCE_HXX
+
+#include "stochastic.hxx"
+
+using namespace std;
+
+class SimpleSynapse;
+
+/// The summed conductance of many synapses onto one neuron.
+/** All synapses onto a neuron with the same decay time constant and reversal potential decay together, so their conductances can be kept as one sum, which jumps at each pre-synaptic spike. This object keeps one such sum for each class of (time constant, reversal potential), and behaves like a synapse with the value
+    \f[ f(V) = \sum_c (v_c - V) G^c_t, \f]
+    to be added to a neuron with IfNeuron::addStimulus(). Each step costs one multiplication per class, plus one check per input for a pre-synaptic spike, instead of one differential equation per synapse.
+    Inputs can be SimpleSynapse objects (see addSynapse()), which then stop integrating on their own, or be given directly (see addInput()). As in SimpleSynapse, a spike sets the conductance of the input to its peak value, and the jump of the sum is found from the time of the input's last spike, so the result is the same as summing the single synapses, except that the sum starts at zero, while a SimpleSynapse starts at its peak conductance. The decay is integrated exactly. The value is affine in V, so the exponential mode of DifferentialEquation can integrate it exactly as well. */
+class AggregateConductance: public StochasticFunction
+{
+private:
+	// classes
+	vector<double> aggregateTau; // decay time constant of each class
+	vector<double> aggregateReversal; // reversal potential of each class
+	vector<double> aggregateDecay; // decay of each class during one step
+	vector<double> aggregateState; // current conductance of each class
+	vector<double> aggregateStateNext; // next conductance of each class
+	vector<double> aggregateJump; // jump of each class from spikes in this step, part of the current conductance until proceeding
+	
+	// inputs
+	vector<StochasticEventGenerator *> aggregatePre; // pre-synaptic neuron of each input
+	vector<uint> aggregateClass; // class of each input
+	vector<double> aggregatePeak; // weight times peak conductance of each input
+	vector<long> aggregateLastSpike; // step of the last spike of each input, -1 if none
+	long aggregateStep; // steps since init
+	
+	/// Find or make the class of a time constant and reversal potential.
+	uint getClass( double tau, double revPot );
+	
+	/// Compute the decay of all classes.
+	void updateDecay();
+	
+public:
+	/// Construct.
+	AggregateConductance(
+		Time *time, ///< global time object
+		const string& name="", ///< object name
+		const string& type="Aggregate Conductance" ///< object type
+	);
+	
+	/// Destroy.
+	virtual ~AggregateConductance() {};
+	
+	/// Add an input.
+	/** The conductance of the input is set to the peak conductance at each spike of the pre-synaptic neuron, and decays with the time constant, as in SimpleSynapse. \return index of the input */
+	uint addInput(
+		StochasticEventGenerator *pre, ///< pre-synaptic neuron
+		double weight, ///< synaptic weight
+		double revPot, ///< reversal potential
+		double peak, ///< peak conductance
+		double tau ///< decay time constant
+	);
+	
+	/// Take over a SimpleSynapse.
+	/** The synapse is added as an input with its own parameters, and removed from its time object, so it, its rate equation and its clock are no longer stepped. Add this object to the neuron instead of the synapse. Synapses driven by a noise source can't be aggregated. \return index of the input, or -1 */
+	int addSynapse( SimpleSynapse *synapse );
+	
+	/// Number of classes of (time constant, reversal potential).
+	uint getClasses() const { return aggregateTau.size(); };
+	
+	/// Number of inputs.
+	uint getInputAmount() const { return aggregatePre.size(); };
+	
+	/// Current conductance of a class.
+	/** Includes the jump of spikes seen in this step once the next state is prepared. */
+	double getConductance( uint c ) const { return aggregateState[c] + aggregateJump[c]; };
+	
+	/// Value at the current input.
+	virtual double calculateCurrentValue();
+	
+	/// Value at the next input.
+	virtual double calculateNextValue();
+	
+	/// Derivative, minus the summed conductance.
+	virtual double getDerivative(double x);
+	
+	/// Affine form, summed conductance times reversal potential, minus summed conductance.
+	virtual bool getAffine(double &offset, double &slope);
+	
+	/// Objects this conductance reads.
+	/** These are the pre-synaptic neurons. */
+	virtual void getInputs( vector<TimeDependent *> &inputs ) { inputs.insert(inputs.end(), aggregatePre.begin(), aggregatePre.end()); };
+	
+	/// Decay the classes and add the jumps of spiking inputs.
+	virtual void prepareNextState();
+	
+	/// Advance.
+	virtual void proceedToNextState();
+	
+	/// Set all conductances to zero.
+	virtual void init();
+};
+
+#endif
@@ -0,0 +1,92 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#ifndef __CALENDAR_HXX
+#define __CALENDAR_HXX
+
+#include <vector>
+#include <sys/types.h>
+
+using namespace std;
+
+/// Calendar queue for delayed events.
+/** A ring of buckets, one for each time step up to the longest delay. An item scheduled with a delay of d steps lands in the bucket d steps ahead of the current one, and is due when the calendar has been advanced d times. Scheduling and delivery cost one push and one read per item, no matter how many items are waiting for other steps. All functions are inline, like Ring and Queue. */
+template<typename T>
+class Calendar
+{
+private:
+	vector<vector<T> > calendarSlots;
+	uint calendarCurrent;
+	
+public:
+	/// New calendar.
+	/** @param maxDelay Longest delay, in time steps. */
+	Calendar(uint maxDelay = 0) {
+		resize(maxDelay);
+	};
+	
+	~Calendar() {};
+	
+	/// Set the longest delay.
+	/** Removes all scheduled items. */
+	void resize(uint maxDelay) {
+		calendarSlots.assign(maxDelay + 1, vector<T>());
+		calendarCurrent = 0;
+	};
+	
+	/// Longest delay.
+	uint getMaxDelay() const {
+		return calendarSlots.size() - 1;
+	};
+	
+	/// Schedule an item.
+	/** @param delay Number of steps until the item is due, at most getMaxDelay(). A delay of 0 makes it due now. */
+	void schedule(uint delay, const T &item) {
+		uint slot = calendarCurrent + delay;
+		if (slot >= calendarSlots.size())
+			slot -= calendarSlots.size();
+		calendarSlots[slot].push_back(item);
+	};
+	
+	/// Items due in the current step.
+	const vector<T> &due() const {
+		return calendarSlots[calendarCurrent];
+	};
+	
+	/// Go to the next step.
+	/** The items of the current step are dropped. */
+	void advance() {
+		calendarSlots[calendarCurrent].clear();
+		if (++calendarCurrent == calendarSlots.size())
+			calendarCurrent = 0;
+	};
+	
+	/// Remove all items.
+	void clear() {
+		for (uint i=0; i<calendarSlots.size(); ++i)
+			calendarSlots[i].clear();
+		calendarCurrent = 0;
+	};
+};
+
+#endif
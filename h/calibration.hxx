@@ -0,0 +1,69 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#ifndef CALIBRATION_HXX
+#define CALIBRATION_HXX
+
+#include "neuron.hxx"
+
+using namespace std;
+
+/// Calibration of many neurons at once.
+/** Calibrating neurons one after another with their calibrate() functions steps the whole network each time, on one thread. This class collects neurons with their target intervals and calibrates all of them concurrently. Each neuron is run on a Time object of its own, which holds only the objects the neuron reads (see Time::getSubgraph()), so unrelated objects are not stepped and independent neurons can run on different threads. Neurons whose inputs overlap, f.i. because they share a noise source or are coupled, form one group which is run on one Time object, and are calibrated one after another. The calibration is done by SpikingNeuron::calibrateThreshold(), the thresholds end up in the neurons themselves. The network must not be run during calibration, and should be initialised afterwards.
+    Objects keep their own time object while another one steps them, so objects reading the time passed (see TimeDependent::readsTimePassed()), like EventPlayer or InhomogeneousPoisson, would see the time stand still. Groups containing such objects are therefore calibrated on the network's time object, after the other groups and one neuron after another, stepping the whole network as SpikingNeuron::calibrate() does. */
+class Calibration
+{
+private:
+	Time *calibrationTime; // time object of the network
+	vector<SpikingNeuron *> calibrationNeurons; // neurons to calibrate
+	vector<int> calibrationIsi; // target interval of each neuron, in time steps
+	
+	// private copy constructor to prevent copying
+	Calibration( const Calibration & );
+	
+public:
+	/// Construct.
+	Calibration(
+		Time *time   ///< time object of the network
+	);
+	
+	/// Add a neuron.
+	void add(
+		SpikingNeuron *neuron,   ///< neuron to calibrate
+		int isi   ///< desired inter-spike interval, given in time steps
+	);
+	
+	/// Number of neurons.
+	uint size() const { return calibrationNeurons.size(); };
+	
+	/// Calibrate all neurons.
+	/** Splits the neurons into groups with disjoint inputs, and lets the given number of threads take the groups one by one. */
+	void run(
+		int spikes,   ///< maximal number of spikes used for one measurement
+		int maxtime,   ///< maximal number of time steps for one batch of spikes
+		uint threads = 1,   ///< number of threads
+		ostream &log = cout   ///< stream for progress messages
+	);
+};
+
+#endif
@@ -104,6 +104,9 @@ public:
 	/// get some property
 	virtual Matrix getEstimate(const Property&);
 	
+	/// add data of another conditional estimator
+	virtual void merge(Estimator *);
+	
 	/// initialize
 	void init();
 	
@@ -46,12 +46,23 @@ public:
 	/// Destruct.
 	~Covariation() {};
 	
+	/// Objects this process depends on.
+	/** These are both processes, their increments are used. */
+	void getDependencies( vector<TimeDependent *> &dependencies ) {
+		dependencies.push_back( xFirst );
+		dependencies.push_back( xSecond );
+	};
+	
 	/// Calculate next value.
 	/** If the process is active, this is called automatically. If it is passive, call proceedToNextState() first, and then prepareNextState(), to complete a full step.. */
 	void prepareNextState() {
 		stochNextValue += xFirst->getIncrement() * xSecond->getIncrement();
 		stochNextStateIsPrepared = true;
 	};
+	
+	/// Whether the process may sleep.
+	/** True if the increment vanishes, the process then keeps its value until one of the processes changes. */
+	virtual bool isDormant() { return stochNextValue == stochCurrentValue; };
 };
 
 #endif
@@ -49,8 +49,14 @@ using namespace std;
    mode can be set by calling setStratonovich(). Which mode is used can
    be tested by querying isIto() (true if Ito mode) or isStratonovich() (true
    if Stratonovich integrals are used).
-   At the moment there is only the 0.5-strong-order Euler scheme
-   implemented, but Milstein and Taylor of higher order are planned for the future. See the main page for display of the error made when integrating. Here is a short example of the difference of Ito and Stratonovich integration (the equation is \f$dX_t = aX_tdt + bX_tdW_t\f$ or \f$dX_t = aX_tdt + bX_t\circ dW_t\f$ with \f$a=-8.0\f$ and \f$b=0.8\f$.):
+   Both modes use the 0.5-strong-order Euler scheme, the Stratonovich
+   integral is found by a fixed-point iteration (setStratonovich()).
+   For It\^o equations there are two schemes of strong order 1.0: the
+   Milstein scheme (setMilstein()), and a derivative-free Runge-Kutta scheme
+   (setRungeKutta()), see there.
+   For membrane-like equations whose integrands are affine in \f$X\f$ there is
+   also an exponential mode (setExponential()), which integrates the linear
+   part exactly, see stepExponential(). See the main page for display of the error made when integrating. Here is a short example of the difference of Ito and Stratonovich integration (the equation is \f$dX_t = aX_tdt + bX_tdW_t\f$ or \f$dX_t = aX_tdt + bX_t\circ dW_t\f$ with \f$a=-8.0\f$ and \f$b=0.8\f$.):
 
    The integrands \f$f_i(X_t)\f$ are objects of the type Integrand,
    and the integrators \f$dY_i\f$ are objects of the type
@@ -158,6 +164,10 @@ public:
 		int n   ///< index of term
 	);
 	
+	/// Objects this equation depends on.
+	/** These are all integrators and integrands. */
+	virtual void getDependencies( vector<TimeDependent *> &dependencies );
+	
 	/// Get parameter.
 	/** In a derived class, override this to handle every parameter you implement. If a parameter is described using multiple strings separated by space, this indicates a parameter of a parameter.  */
 	virtual string getParameter (
@@ -184,7 +194,103 @@ public:
 	void setIto();
 	
 	/// Set integration mode to Stratonovich
-	void setStratonovich();
+	/** The Stratonovich integral is found by a fixed-point iteration starting from the Euler step. Two iterations are usually enough, use more for stiff or strongly multiplicative equations. */
+	void setStratonovich(
+		int iterations=2   ///< number of fixed-point iterations
+	);
+	
+	/// Number of fixed-point iterations in Stratonovich mode.
+	int getIterations() const { return eqnIterations; };
+	
+	/// Is integration mode Milstein?
+	bool isMilstein() const;
+	
+	/// Set integration mode to Milstein.
+	/** The Euler-Ito step is corrected by
+	    \f[ \frac{1}{2}\sum_{j,k} f_k'(X) f_j(X) \left(\Delta Y_j\Delta Y_k - \delta_{jk}[Y_j]_\Delta\right), \f]
+	    where the sum goes over all diffusive integrators, i.e. those with
+	    a non-zero quadratic variation \f$[Y_j]_\Delta\f$ (see
+	    StochasticProcess::getQuadraticVariation()). The derivatives come
+	    from StochasticFunction::getDerivative(). The scheme has strong
+	    order 1.0 if the noise is commutative, e.g. for a single Wiener
+	    process, otherwise the neglected Levy areas limit it to 0.5. */
+	void setMilstein();
+	
+	/// Is integration mode Runge-Kutta?
+	bool isRungeKutta() const;
+	
+	/// Set integration mode to stochastic Runge-Kutta.
+	/** The same correction as in the Milstein scheme, but the derivatives
+	    are replaced by differences of the integrands at supporting values
+	    \f$X + \sum_j f_j(X)\Delta Y_j\f$ and \f$X \pm f_j(X)\sqrt{[Y_j]_\Delta}\f$,
+	    in the spirit of Platen's explicit order 1.0 scheme. Use this if
+	    the integrands have no closed-form derivative. */
+	void setRungeKutta();
+	
+	/// Is integration mode adaptive?
+	bool isAdaptive() const;
+	
+	/// Set integration mode to adaptive sub-stepping.
+	/** Each time step is integrated with the Milstein scheme (see
+	    setMilstein()), and compared against two steps of half the size.
+	    If the two results differ by more than the tolerance, both halves
+	    are refined recursively, up to the given depth, i.e. up to
+	    \f$2^{depth}\f$ sub-steps. The increments of diffusive integrators
+	    are split with a Brownian bridge, so the refined path passes
+	    through the same noise as the coarse one and the integrators'
+	    increments over the whole step are kept. Time terms are split
+	    linearly, other integrators (e.g. spike trains) are applied in
+	    the first sub-step, as in Euler. The global time step is not
+	    changed, so all other objects, estimators and generators still
+	    see regular samples. Far from threshold a single step is taken,
+	    near it the membrane is resolved finely. */
+	void setAdaptive(
+		double tolerance,   ///< absolute tolerance of one time step
+		int depth=6   ///< maximal number of step halvings
+	);
+	
+	/// Number of sub-steps used in the last time step.
+	int getSubsteps() const {
+		return eqnSubsteps;
+	}
+	
+	/// Quadratic variation of one step.
+	/** This is \f$\sum_i f_i(X)^2[Y_i]_\Delta\f$, so equations can drive other equations with higher-order schemes. */
+	virtual double getQuadraticVariation();
+	
+	/// Is integration mode exponential?
+	bool isExponential() const;
+	
+	/// Set integration mode to exponential.
+	/** Terms with affine integrands \f$f_i(X) = a_i + b_i X\f$ (see
+	    StochasticFunction::getAffine()) driven by time or by Wiener
+	    processes are collected into the linear SDE
+	    \f[ dX = (A + BX)\,dt + \sum_i (a_i + b_i X)\,\sigma_i dW_i, \f]
+	    whose drift is integrated in closed form:
+	    \f[ X_{t+\Delta} = e^{B\Delta}X_t + \frac{e^{B\Delta}-1}{B}A
+	       + \sqrt{\frac{e^{2B\Delta}-1}{2B\Delta}} \sum_i (a_i + b_i X_t)\,\sigma_i\Delta W_i. \f]
+	    For additive noise this is the exact Ornstein-Uhlenbeck transition
+	    (mean decay and increment variance), so much larger time steps
+	    can be used than with Euler. Wiener means enter the drift, so
+	    mean conductances contribute to the decay rate \f$B\f$. Terms that
+	    are not affine, or are driven by other integrators (e.g. Poisson
+	    spike trains), are added as Ito-Euler jumps. */
+	void setExponential();
+	
+	/// Diffusion approximation of the equation.
+	/** If all terms are affine and driven by time or Wiener processes, the
+	    equation is the linear SDE described in setExponential(). This
+	    returns its drift per unit time as offset \f$A\f$ and slope \f$B\f$,
+	    and the variance per unit time of its noise at the given value,
+	    \f$\sum_i (a_i + b_i x)^2\sigma_i^2\f$, using the current coefficients
+	    of the integrands.
+	    \returns false if the equation has other terms. */
+	bool getDiffusion(
+		double x,          ///< value to evaluate the noise at
+		double &offset,    ///< constant part of the drift
+		double &slope,     ///< linear part of the drift
+		double &variance   ///< variance of the noise per unit time
+	);
 
 private:
 	int eqnTermAmount; // number of terms
@@ -195,6 +301,43 @@ private:
 	void stepEulerIto();
 	// calculate value according to Stratonovich (Euler method)
 	void  stepEulerStratonovich();
+	// calculate value with exact integration of the linear part
+	void stepExponential();
+	// calculate value according to Milstein
+	void stepMilstein();
+	// calculate value with the derivative-free Runge-Kutta scheme
+	void stepRungeKutta();
+	// find diffusive terms, sum the Euler-Ito increment
+	double stepEulerTerms(double x);
+	// integrate adaptively with step doubling
+	void stepAdaptive();
+	// integrate a part of the time step, refining where needed
+	double stepAdaptiveInterval(double x, double fraction, int depth, const double *increments, bool first);
+	// one Milstein sub-step over a part of the time step
+	double stepSubstep(double x, double fraction, const double *increments, bool first);
+	// sort integrators into time, Wiener and other
+	void updateTermKinds();
+	
+	double eqnTolerance;              // absolute tolerance in adaptive mode
+	int eqnDepth;                     // maximal number of step halvings
+	int eqnSubsteps;                  // sub-steps taken in the last step
+	RandN *eqnBridge;                 // random numbers for Brownian bridges
+	vector<int> eqnDiffusiveIndex;    // index into the diffusive terms, or -1
+	vector<double> eqnBridgeIncrements; // increments of the diffusive terms per level
+	
+	int eqnIterations;                // fixed-point iterations in Stratonovich mode
+	vector<int> eqnDiffusive;         // indices of terms with quadratic variation
+	vector<double> eqnDiffusiveValues; // their integrands at the current value
+	vector<double> eqnDiffusiveQV;     // their quadratic variation
+	
+	// integrator kinds, as far as the exponential mode needs to know them
+	enum TermKind { TERM_TIME, TERM_WIENER, TERM_OTHER };
+	vector<int> eqnTermKinds;   // kind of each integrator
+	bool eqnTermKindsValid;     // false after terms changed
+	double eqnExpRate;          // B*dt the coefficients below were computed for
+	double eqnExpDecay;         // exp(B*dt)
+	double eqnExpDrift;         // (exp(B*dt)-1)/(B*dt)
+	double eqnExpNoise;         // sqrt((exp(2B*dt)-1)/(2B*dt))
 };
 
 
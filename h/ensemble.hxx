@@ -0,0 +1,128 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#ifndef ENSEMBLE_HXX
+#define ENSEMBLE_HXX
+
+#include "stochastic.hxx"
+#include "differentiable.hxx"
+
+using namespace std;
+
+class IfNeuron;
+
+/// Many realisations of one model, stepped together.
+/** An ensemble holds the state of a DifferentialEquation or an IfNeuron for a number of independent realisations (lanes) in contiguous arrays, and advances all lanes in one step with plain loops the compiler can vectorise. The model is only used as a template: its terms are read at construction and at each init(), the model itself is not stepped. Supported terms have an affine integrand (see StochasticFunction::getAffine(), f.i. Scalar, Product, VoltageDependance) and a TimeProcess, Wiener or Poisson integrator. Other terms are ignored with a message. Each lane draws its own noise, all lanes at once with RandN::fillN(). Use EnsembleEstimator and EnsembleIntervalEstimator to collect results over all lanes. */
+class Ensemble: public TimeDependent, public RandN
+{
+private:
+	/// Kinds of integrators.
+	enum SourceType { SOURCE_TIME, SOURCE_WIENER, SOURCE_POISSON };
+	
+	DifferentialEquation *ensembleEquation; // the model equation
+	IfNeuron *ensembleNeuron; // the model neuron, 0 if the model is an equation
+	uint ensembleLanes; // number of realisations
+	
+	// model
+	double ensembleX0; // starting value
+	bool ensembleStratonovich; // integration mode
+	int ensembleIterations; // fixed-point iterations in Stratonovich mode
+	double ensembleTheta; // threshold
+	double ensembleSpikeHeight; // value during a spike
+	vector<double> ensembleOffsets; // offset of each term
+	vector<double> ensembleSlopes; // slope of each term
+	vector<uint> ensembleTermSources; // integrator of each term
+	vector<SourceType> ensembleSourceTypes; // kind of each integrator
+	vector<double> ensembleSourceMeans; // mean increment per step
+	vector<double> ensembleSourceStdDevs; // std. dev. of increment per step
+	vector<vector<double> > ensembleIncrements; // increments of each integrator, per lane
+	
+	// state, per lane
+	vector<double> ensembleCurrent; // current membrane value
+	vector<double> ensembleNext; // next membrane value
+	vector<double> ensembleValueCurrent; // current output (spike height during a spike)
+	vector<double> ensembleValueNext; // next output
+	vector<char> ensembleEventCurrent; // current events
+	vector<char> ensembleEventNext; // next events
+	vector<double> ensembleSum; // Ito sum
+	vector<double> ensembleDrift; // Stratonovich correction
+	bool ensembleNextStateIsPrepared;
+	
+	/// Read terms and parameters of the model.
+	void compile();
+	
+	// private copy constructor to prevent copying
+	Ensemble( const Ensemble & );
+	
+public:
+	/// Construct.
+	/** Creates an ensemble of realisations of a differential equation. */
+	Ensemble(
+		Time *time, ///< Time object stepping the ensemble
+		DifferentialEquation *equation, ///< model
+		uint lanes ///< number of realisations
+	);
+	
+	/// Construct.
+	/** Creates an ensemble of realisations of an integrate-and-fire neuron. */
+	Ensemble(
+		Time *time, ///< Time object stepping the ensemble
+		IfNeuron *neuron, ///< model
+		uint lanes ///< number of realisations
+	);
+	
+	/// Destroy.
+	virtual ~Ensemble() {};
+	
+	/// Number of realisations.
+	uint getLanes() const { return ensembleLanes; };
+	
+	/// Whether the model spikes.
+	bool isSpiking() const { return ensembleNeuron != 0; };
+	
+	/// Current values of all lanes.
+	/** For a neuron this is the output, i.e. the spike height during a spike. */
+	const double *getCurrentValues() const { return ensembleNeuron ? &ensembleValueCurrent[0] : &ensembleCurrent[0]; };
+	
+	/// Next values of all lanes.
+	const double *getNextValues() const { return ensembleNeuron ? &ensembleValueNext[0] : &ensembleNext[0]; };
+	
+	/// Current events of all lanes.
+	/** All zero if the model doesn't spike. */
+	const char *getEvents() const { return &ensembleEventCurrent[0]; };
+	
+	/// Reset all lanes to the starting value.
+	/** Re-reads the model, so that changes of its parameters take effect. */
+	virtual void init();
+	
+	/// Calculate next state of all lanes.
+	virtual void prepareNextState();
+	
+	/// Advance all lanes.
+	virtual void proceedToNextState();
+	
+	/// Whether the next state is prepared.
+	virtual bool isNextStatePrepared() { return ensembleNextStateIsPrepared; };
+};
+
+#endif
@@ -0,0 +1,57 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#ifndef ENSEMBLE_ESTIMATOR_H
+#define ENSEMBLE_ESTIMATOR_H
+
+#include "scalarestimator.hxx"
+#include "ensemble.hxx"
+
+/// estimates mean, variance, etc. over all lanes of an ensemble
+/** Each time step gives one sample per lane. Use EST_DIFF to record increments instead of values. */
+class EnsembleEstimator: public ScalarEstimator
+{
+protected:
+	Ensemble *pEnsemble;
+public:
+	EnsembleEstimator(const Property&, Ensemble *, class Time *); ///< Constructor
+	virtual ~EnsembleEstimator(); ///< Destructor
+	virtual void collect(); ///< Eat next piece of data of all lanes
+};
+
+/// estimates interval distribution, mean, var, etc. over all lanes of an ensemble
+/** Records inter-event intervals of each lane of a spiking ensemble, like IntervalEstimator does for a single event generator. */
+class EnsembleIntervalEstimator: public ScalarEstimator
+{
+private:
+	vector<long> aTime; // steps since last event, per lane
+protected:
+	Ensemble *pEnsemble;
+public:
+	EnsembleIntervalEstimator(const Property&, Ensemble *, class Time *); ///< Constructor
+	virtual ~EnsembleIntervalEstimator(); ///< Destructor
+	virtual void collect(); ///< Eat next piece of data of all lanes
+	virtual void init(); ///< reset all counters
+};
+
+#endif
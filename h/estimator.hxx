@@ -85,6 +85,10 @@ public:
 	
 	virtual void collect() = 0; ///< Eat the next data point.
 	virtual Matrix getEstimate(const Property&) = 0; ///< Return an estimation.
+	
+	/// Add the data of another estimator.
+	/** The other estimator must be of the same type and record the same properties, afterwards this estimator holds the results of both. Used to combine parallel runs. The default only prints a message. */
+	virtual void merge( Estimator *other );
 };
 
 
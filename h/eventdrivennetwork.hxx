@@ -0,0 +1,277 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#ifndef EVENTDRIVENNETWORK_HXX
+#define EVENTDRIVENNETWORK_HXX
+
+#include "stochastic.hxx"
+#include <queue>
+
+using namespace std;
+
+class EventDrivenNetwork;
+
+/// One neuron of an EventDrivenNetwork.
+/** A view of a single cell, so that estimators and synapses which expect a StochasticEventGenerator can attach to it. Its value is the membrane voltage at the time step, or the spike height if the cell spiked during the step. The offset of the spike within the step is exact (see StochasticEventGenerator::getEventOffset()), so IntervalEstimator measures exact intervals. Views are made by EventDrivenNetwork::getNeuron(). */
+class EventDrivenNeuron: public StochasticEventGenerator
+{
+private:
+	EventDrivenNetwork *neuronNetwork; // the network
+	uint neuronIndex; // index of the cell
+	uint neuronEventAmount; // spikes during the current step
+	uint neuronEventAmountNext; // spikes during the next step
+	
+	// private copy constructor to prevent copying
+	EventDrivenNeuron( const EventDrivenNeuron & );
+	
+protected:
+	/// Construct.
+	/** Only the network makes views. */
+	EventDrivenNeuron( EventDrivenNetwork *network, uint index );
+	
+public:
+	/// Destroy.
+	virtual ~EventDrivenNeuron() {};
+	
+	/// Index of the cell in the network.
+	uint getIndex() const { return neuronIndex; };
+	
+	/// Objects this view depends on.
+	/** This is the network. */
+	virtual void getDependencies( vector<TimeDependent *> &dependencies );
+	
+	/// Copy the state of the cell at the next time step.
+	virtual void prepareNextState();
+	
+	/// Go to the next time step.
+	virtual void proceedToNextState();
+	
+	/// The amount of spikes during the step.
+	/** The offset is the one of the last spike. */
+	virtual uint getEventAmount() { return neuronEventAmount; };
+	
+	/// Copy the state of the cell.
+	virtual void init();
+	
+friend class EventDrivenNetwork;
+};
+
+/// Current-based integrate-and-fire neurons, simulated from event to event.
+/** A network of leaky integrate-and-fire neurons with the membrane equation
+    \f[ \tau\frac{dV_t}{dt} = v_L - V_t + \tau\mu + \tau\sum_k w_k\delta(t - t_k), \f]
+    where \f$\mu\f$ is a constant bias current (see setBias()), and each input event k makes the voltage jump by its weight \f$w_k\f$. Inputs are independent Poisson processes onto single cells (see addPoissonInput()), and the spikes of other cells, which arrive through connections with a weight and a delay (see connect()).
+    Between events the voltage relaxes exactly towards \f$ V_\infty = v_L + \tau\mu \f$, so a cell is only touched when an event reaches it. If \f$V_\infty\f$ lies above the threshold, the time of the threshold crossing is computed exactly, \f[ t^* = t + \tau\ln\frac{V_t - V_\infty}{\theta - V_\infty}, \f] and put into the event queue; a jump across the threshold makes a spike at once. After a spike the voltage is held at the reset value for the refractory period, inputs arriving meanwhile are lost. All events are kept in one priority queue, predicted crossings which are overtaken by an input are dropped when they come up.
+    The network is stepped by Time like any other object: each step processes the events up to the next time step, in the order of their exact times, so the cost of a step is the number of events in it, not the number of cells or steps. Use getNeuron() to attach estimators or synapses to single cells, the spike times are passed on as offsets within the step. Poisson inputs are exact in continuous time, unlike Poisson objects, which have at most one event per step. The result does not depend on the time step, except for the time resolution of what the views show. */
+class EventDrivenNetwork: public TimeDependent, public RandN
+{
+	friend class EventDrivenNeuron;
+	
+public:
+	/// Kind of an event in the queue.
+	enum EventKind {
+		EVENT_INPUT, ///< a Poisson input fires
+		EVENT_ARRIVAL, ///< a spike arrives through a connection
+		EVENT_THRESHOLD ///< a predicted threshold crossing
+	};
+	
+	/// An event in the queue.
+	struct Event {
+		double time; ///< time of the event
+		EventKind kind; ///< kind of the event
+		uint index; ///< the input, the connection, or the cell
+		uint version; ///< state of the cell a crossing was predicted from
+		
+		bool operator>( const Event &e ) const { return time > e.time; };
+	};
+	
+private:
+	uint networkSize; // number of cells
+	double networkSpikeHeight; // value during a spike
+	double networkRefractoryPeriod; // time held at reset after a spike
+	double networkClock; // time of the current state
+	double networkNextClock; // time of the next state
+	bool networkNextStateIsPrepared;
+	bool networkConnectionsValid; // false after connections were added
+	
+	// parameters, per cell
+	vector<double> networkTheta; // threshold
+	vector<double> networkReset; // reset potential
+	vector<double> networkRest; // resting potential
+	vector<double> networkTau; // membrane time constant
+	vector<double> networkBias; // bias current
+	
+	// state, per cell
+	vector<double> networkVoltage; // voltage at the time of the last update
+	vector<double> networkUpdate; // time of the last update, or end of the refractory period
+	vector<uint> networkVersion; // number of updates, for dropping overtaken predictions
+	vector<unsigned long> networkSpikeCount; // spikes since init
+	
+	// spikes of the next step
+	vector<uint> networkStepSpikes; // spikes of each cell during the next step
+	vector<double> networkStepOffset; // offset of the last spike of each cell, as fraction of the step
+	vector<uint> networkSpiking; // cells which spike during the next step
+	
+	// Poisson inputs
+	vector<uint> networkInputCells; // target cell of each input
+	vector<double> networkInputRates; // rate of each input
+	vector<double> networkInputWeights; // weight of each input
+	
+	// connections, in compressed rows
+	vector<uint> networkPre, networkPost; // edge lists
+	vector<double> networkEdgeWeights, networkEdgeDelays; // edge lists
+	vector<uint> networkRows; // first connection of each cell, and the end
+	vector<uint> networkTargets; // target cell of each connection
+	vector<double> networkWeights; // weight of each connection
+	vector<double> networkDelays; // delay of each connection
+	
+	priority_queue<Event, vector<Event>, std::greater<Event> > networkQueue; // pending events
+	vector<EventDrivenNeuron *> networkViews; // views of single cells, 0 if not made
+	
+	/// Sort the connections into rows.
+	void buildConnections();
+	
+	/// Voltage of a cell at time t, without events since its last update.
+	double voltage( uint cell, double t ) const {
+		double v = networkVoltage[cell];
+		double elapsed = t - networkUpdate[cell];
+		if (elapsed <= 0.0)
+			return v;
+		double target = networkRest[cell] + networkTau[cell] * networkBias[cell];
+		return target + (v - target) * exp(-elapsed / networkTau[cell]);
+	};
+	
+	/// Set the voltage of a cell at time t, and predict its threshold crossing.
+	void update( uint cell, double t, double v );
+	
+	/// Let a cell spike at time t.
+	void spike( uint cell, double t, double stepEnd );
+	
+	/// Schedule the next event of a Poisson input after time t.
+	void scheduleInput( uint input, double t );
+	
+	/// Process all events up to time t.
+	void process( double t, double stepEnd );
+	
+	// private copy constructor to prevent copying
+	EventDrivenNetwork( const EventDrivenNetwork & );
+	
+public:
+	/// Construct.
+	/** Creates a network of identical, unconnected neurons, with the same parameters as IfNeuron. */
+	EventDrivenNetwork(
+		Time *time, ///< Time object stepping the network
+		uint size, ///< number of cells
+		double v0, ///< reset potential
+		double theta, ///< threshold potential
+		double spikeheight, ///< height of a spike in mV
+		double tau, ///< membrane time constant
+		double v_rest ///< resting potential
+	);
+	
+	/// Destroy.
+	virtual ~EventDrivenNetwork();
+	
+	/// Number of cells.
+	uint getSize() const { return networkSize; };
+	
+	/// Set the threshold of one cell.
+	void setThreshold( uint cell, double theta );
+	
+	/// Set the reset potential of one cell.
+	void setReset( uint cell, double v0 );
+	
+	/// Set resting potential and time constant of one cell.
+	void setLeak( uint cell, double v_rest, double tau );
+	
+	/// Set the bias current of all cells.
+	void setBias( double mean );
+	
+	/// Set the bias current of one cell.
+	void setBias( uint cell, double mean );
+	
+	/// Set the refractory period of all cells.
+	/** After a spike the voltage is held at the reset value for this time. The default is 0. */
+	void setRefractoryPeriod( double period );
+	
+	/// Add a Poisson input to one cell.
+	/** Each event of the input makes the voltage of the cell jump by the weight. Takes effect at the next init(). \returns the index of the input. */
+	uint addPoissonInput(
+		uint cell, ///< target cell
+		double rate, ///< rate of the input
+		double weight ///< jump of the voltage at each event
+	);
+	
+	/// Connect two cells.
+	/** Each spike of cell pre makes the voltage of cell post jump by the weight, after the delay. A delay of 0 takes effect at the time of the spike, but after it. Takes effect at the next init(). */
+	void connect(
+		uint pre, ///< pre-synaptic cell
+		uint post, ///< post-synaptic cell
+		double weight, ///< jump of the voltage
+		double delay ///< delay, in units of time
+	);
+	
+	/// Connect cells from edge lists.
+	/** Edge i connects cell pre[i] to post[i], as connect(). */
+	void connect(
+		const vector<uint> &pre, ///< pre-synaptic cell of each edge
+		const vector<uint> &post, ///< post-synaptic cell of each edge
+		const vector<double> &weights, ///< weight of each edge
+		const vector<double> &delays ///< delay of each edge
+	);
+	
+	/// A view of one cell.
+	/** Made at the first call, and owned by the network. */
+	EventDrivenNeuron *getNeuron( uint cell );
+	
+	/// Voltage of a cell at the current time.
+	/** Between prepareNextState() and proceedToNextState() this includes the events of the step. */
+	double getVoltage( uint cell ) const { return voltage(cell, networkClock); };
+	
+	/// Spikes of a cell since init().
+	unsigned long getSpikeCount( uint cell ) const { return networkSpikeCount[cell]; };
+	
+	/// Time of the current state.
+	/** The time since init(). */
+	double getClock() const { return networkClock; };
+	
+	/// Number of pending events.
+	uint getPendingEvents() const { return networkQueue.size(); };
+	
+	/// Run without time steps.
+	/** Processes all events up to the given time since init(), and makes it the current time. Spikes are counted (see getSpikeCount()), but not shown by the views. Use this to simulate a network for which nothing is recorded at every time step. */
+	void advance( double t );
+	
+	/// Reset all cells, and draw the first events of all inputs.
+	virtual void init();
+	
+	/// Process the events up to the next time step.
+	virtual void prepareNextState();
+	
+	/// Go to the next time step.
+	virtual void proceedToNextState();
+	
+	/// Whether the next state is prepared.
+	virtual bool isNextStatePrepared() { return networkNextStateIsPrepared; };
+};
+
+#endif
@@ -52,6 +52,10 @@ public:
     /// Proceed to the next time step
     virtual void proceedToNextState();
     
+    /// Objects this multiplexer reads.
+    /*! These are the sources, only their current state is used. */
+    virtual void getInputs( vector<TimeDependent *> &inputs ) { inputs.insert(inputs.end(), multiSources.begin(), multiSources.end()); };
+    
     /// Sets the mode (true - or, false - and)
     void setMode(const bool& mode) { multiMode = mode; };
     
@@ -47,6 +47,9 @@ public:
 	/// Reset all time dependent values.
 	virtual void init();
 	
+	/// Events are played at the time passed.
+	virtual bool readsTimePassed() { return true; };
+	
 	/// Returns the time point of the first event
 	double getStartTime();
 
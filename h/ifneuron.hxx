@@ -26,20 +26,26 @@ __________________________________________________________________________
 
 #include "neuron.hxx"
 #include "noises.hxx"
+#include "aggregateconductance.hxx"
 
 using namespace std;
 
 /// class implementing a simple integrate-and-fire neuron
-/** This class implements an integrate-and-fire neuron. The neuron can be used with conductances, synapses or simple stochastic input. Ito and Stratonovitch integrals may be used (use setIto() or setStratonovich() from DifferentialEquation), and can be used as a trigger for ConditionalEstimator. The function is \f[ dV_t = \frac{1}{C} (v_L - V_t) g_L dt + \sum_i \frac{1}{C} w_i (v_i - V_t) dG^i_t \f] when conductances are used, or \f[ dV_t = \frac{1}{C} (v_L - V_t) g_L dt + \frac{1}{C} w dG^i_t \f] when currents are used. \f$ V_t \f$ is the membrane voltage, \f$ C \f$ is the membrane capacity which is always set to \f$ 1 \mu F \f$, \f$ v_L \f$ is the leak reversal potential, \f$ g_L \f$ is the leak conductance. \f$ w_i, v_i, dG^i \f$ are weight, reversal potential and conductance of a stimulating synapse. */
+/** This class implements an integrate-and-fire neuron. The neuron can be used with conductances, synapses or simple stochastic input. Ito and Stratonovitch integrals may be used (use setIto() or setStratonovich() from DifferentialEquation), as well as the exponential mode which integrates the leak exactly and allows much larger time steps (set parameter "membrane integration-mode" to "exponential"), and can be used as a trigger for ConditionalEstimator. The function is \f[ dV_t = \frac{1}{C} (v_L - V_t) g_L dt + \sum_i \frac{1}{C} w_i (v_i - V_t) dG^i_t \f] when conductances are used, or \f[ dV_t = \frac{1}{C} (v_L - V_t) g_L dt + \frac{1}{C} w dG^i_t \f] when currents are used. \f$ V_t \f$ is the membrane voltage, \f$ C \f$ is the membrane capacity which is always set to \f$ 1 \mu F \f$, \f$ v_L \f$ is the leak reversal potential, \f$ g_L \f$ is the leak conductance. \f$ w_i, v_i, dG^i \f$ are weight, reversal potential and conductance of a stimulating synapse. */
 
 class IfNeuron : public SpikingNeuron
 {
+	friend class Ensemble;
+	friend class PopulationDensity;
+	
 private:
 	DifferentialEquation ifneuronMembrane; // the membrane equation
 	
 protected:
 	double ifneuronSpikeHeight; // height of a spike. This is cosmetical, really.
 	double ifneuronTheta; // threshold
+	bool ifneuronCrossing; // whether crossings between time steps are detected
+	RandN *ifneuronBridge; // random numbers for crossing detection
 	
 	/// Construct.
 	/** Default constructor only to be used by derived classes. */
@@ -63,17 +69,35 @@ public:
 	~IfNeuron();
 	
 	/// Calibrate the neuron
-	/** Set the neuron to a specific reponse rate. This is achieved by internally adjusting the threshold.
+	/** Set the neuron to a specific reponse rate. This is achieved by internally adjusting the threshold (see SpikingNeuron::calibrateThreshold()).
 	If you do not give a NoiseSource object, all inputs to the neuron must be active for this to work. If the neuron receives passive processes (like correlated noise from a NoiseSource), you *must* give the address of the NoiseSource object driving them. */
 	void calibrate(
 		int isi, ///< Desired inter-spike interval, given in time steps.
-		int runs, ///< Number of runs used to estimate threshold. 50 is a good compromise.
-		int maxtime, ///< Maximum time for one run to take. 10*isi is a good compromise
+		int runs, ///< Maximal number of spikes used to estimate the interval. 50 is a good compromise.
+		int maxtime, ///< Maximum time for one batch of spikes to take. 10*isi is a good compromise
 		NoiseSource *noises = 0, ///< Address of a NoiseSource object.
 		double increment = 1.1, ///< factor used for increasing step size when direction is kept
 		double decrement = 0.8 ///< factor used for decreasing step size when direction is changed
 	);
 	
+	/// Calibrate the neuron analytically.
+	/** For a membrane driven only by time and Wiener processes (see DifferentialEquation::getDiffusion()) the membrane is the Ornstein-Uhlenbeck process \f$ dV = \frac{1}{\tau}(\mu - V)dt + \frac{\sigma}{\sqrt{\tau}}dW \f$, whose mean first-passage time from the reset potential \f$v_0\f$ is given by the Siegert formula \f[ T(\theta) = \tau\sqrt{\pi} \int_{(v_0-\mu)/\sigma}^{(\theta-\mu)/\sigma} e^{u^2}(1+\mbox{erf}\,u)\,du. \f] The threshold is found by quadrature and bisection of \f$T(\theta)\f$, then a short simulation of the given number of spikes measures the interval. If the measurement deviates by more than two standard errors, the bias of the time discretisation is subtracted from the target and the formula is solved once more. This takes a fraction of a second instead of the many runs of calibrate(), to which it falls back if the membrane has other inputs.
+	\returns true if the threshold was found analytically. */
+	bool calibrateSiegert(
+		int isi, ///< Desired inter-spike interval, given in time steps.
+		int spikes, ///< Number of spikes used to verify the threshold.
+		int maxtime ///< Maximum time for the verification run to take.
+	);
+	
+	/// Start a calibration at the reset potential.
+	virtual void startCalibration(double &stepsize, double &precision);
+	
+	/// Return the threshold.
+	virtual double getThreshold() const { return ifneuronTheta; };
+	
+	/// Set the threshold.
+	virtual void setThreshold(double theta) { ifneuronTheta = theta; };
+	
 	/// Get parameter.
 	/** In a derived class, override this to handle every parameter you implement. If a parameter is described using multiple strings separated by space, this indicates a parameter of a parameter.  */
 	virtual string getParameter (
@@ -105,6 +129,12 @@ public:
 	This adds a stimulus which is a synapse. The synapse should have the unit mV * mS. */
 	virtual int addStimulus( Synapse *synapse );
 
+	/// Add an aggregate conductance.
+	/** \param conductance The summed conductance of many synapses.
+	\returns The index of the integrator/integrand added.
+	This adds the synapses gathered in an AggregateConductance as one stimulus. */
+	int addStimulus( AggregateConductance *conductance );
+
 	/// Remove a stimulus.
 	/** This removes the nth stimulus from the differential equation */
 	virtual void removeStimulus( int n );
@@ -112,6 +142,12 @@ public:
 	/// Return whether a spike is happening.
 	virtual bool hasEvent();
 	
+	/// Detect threshold crossings between time steps.
+	/** Without correction a spike is only detected if the membrane is above threshold at a time step, which misses the excursions in between and biases inter-spike intervals upwards unless the time step is tiny. With correction the membrane is treated as a Brownian bridge between the two time steps, whose variance is the quadratic variation of the membrane equation (see DifferentialEquation::getQuadraticVariation()). If both values are below threshold, a spike is emitted with the bridge's exit probability \f[ P = \exp\left(-\frac{2(\theta-V_t)(\theta-V_{t+\Delta})}{\sigma^2\Delta}\right). \f] In both cases the spike time within the step is interpolated and reported through getEventOffset(), so IntervalEstimator measures unbiased intervals, and the membrane is reset in the same time step instead of the next one. Can also be set with the parameter "crossing-correction" (1 or 0). */
+	void setCrossingCorrection(
+		bool correction   ///< true to detect crossings between time steps
+	);
+	
 	/// Set the next value of the process.
 	/** This includes both the value of the neuron and the membrane, which is a separate object.. */
 	virtual void setNextValue(double d) { stochNextValue = d; ifneuronMembrane.setNextValue(d); };
@@ -120,6 +156,10 @@ public:
 	/** This includes both the value of the neuron and the membrane, which is a separate object.. */
 	virtual void setCurrentValue(double d) { stochCurrentValue = d; ifneuronMembrane.setCurrentValue(d); };
 	
+	/// Objects this neuron depends on.
+	/** This is the membrane equation. */
+	virtual void getDependencies( vector<TimeDependent *> &dependencies ) { dependencies.push_back(&ifneuronMembrane); };
+	
 	/// step
 	virtual void prepareNextState();
 	virtual void proceedToNextState();
@@ -0,0 +1,241 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#ifndef IFNEURONPOPULATION_HXX
+#define IFNEURONPOPULATION_HXX
+
+#include "stochastic.hxx"
+
+using namespace std;
+
+class IfNeuronPopulation;
+class Synapse;
+
+/// One neuron of an IfNeuronPopulation.
+/** A view of a single cell, so that estimators and synapses which expect a StochasticEventGenerator can attach to it. Its value is the membrane voltage, or the spike height during a spike, as in IfNeuron. Views are made by IfNeuronPopulation::getNeuron(), and only cells which are looked at pay for one. */
+class PopulationNeuron: public StochasticEventGenerator
+{
+private:
+	IfNeuronPopulation *neuronPopulation; // the population
+	uint neuronIndex; // index of the cell
+	
+	// private copy constructor to prevent copying
+	PopulationNeuron( const PopulationNeuron & );
+	
+protected:
+	/// Construct.
+	/** Only the population makes views. */
+	PopulationNeuron( IfNeuronPopulation *population, uint index );
+	
+public:
+	/// Destroy.
+	virtual ~PopulationNeuron() {};
+	
+	/// Index of the cell in the population.
+	uint getIndex() const { return neuronIndex; };
+	
+	/// Objects this view depends on.
+	/** This is the population. */
+	virtual void getDependencies( vector<TimeDependent *> &dependencies );
+	
+	/// Copy the next state of the cell.
+	virtual void prepareNextState();
+	
+	/// Copy the state of the cell.
+	virtual void init();
+	
+friend class IfNeuronPopulation;
+};
+
+/// Many integrate-and-fire neurons in contiguous arrays.
+/** A population of leaky integrate-and-fire neurons, stored as one array per quantity (membrane voltage, threshold, reset, time constant, refractory state, input conductances), and stepped by loops which the compiler can vectorise. A network of thousands of IfNeuron objects spends most of its time in virtual calls and cache misses, a population touches a few contiguous arrays per step.
+    The membrane of each cell follows
+    \f[ dV_t = \frac{1}{\tau} (v_L - V_t) dt + \mu dt + \sigma dW_t + (E_t - G_t V_t) dt, \f]
+    where \f$ \mu, \sigma \f$ is a white-noise drive of each cell (see setDrive()), and \f$ G_t = \sum_j g_j, E_t = \sum_j g_j v_j \f$ sum the synaptic conductances and their reversal potentials. Conductances are added with addConductance(), f.i. by a SparseProjection, and decay with a common synaptic time constant. The leak and the drive are integrated exactly (as in the exponential mode of DifferentialEquation), the synaptic current is held constant over a step. After a spike the voltage is held at the reset value for one step, as in IfNeuron without crossing correction, and for the refractory period.
+    Single cells can additionally receive any stochastic input, including Synapse objects (see addStimulus()), these terms are evaluated one by one, as in IfNeuron. Use getNeuron() to attach estimators or synapses to a single cell, and getSpikes() to find the cells which spiked. */
+class IfNeuronPopulation: public TimeDependent, public RandN
+{
+	friend class PopulationNeuron;
+	
+private:
+	uint populationSize; // number of cells
+	double populationSpikeHeight; // value during a spike
+	double populationRefractoryPeriod; // time held at reset after a spike
+	double populationSynapticTau; // decay time constant of conductances
+	double populationSynapticDecay; // decay of conductances during one step
+	bool populationCoefficientsValid; // false after parameters changed
+	bool populationNextStateIsPrepared;
+	
+	// parameters, per cell
+	vector<double> populationTheta; // threshold
+	vector<double> populationReset; // reset potential
+	vector<double> populationRest; // resting potential
+	vector<double> populationTau; // membrane time constant
+	vector<double> populationMean; // drive, mean per time
+	vector<double> populationStdDev; // drive, std. dev. per square root of time
+	
+	// coefficients of the exact step, per cell
+	vector<double> populationDecay; // exp(-dt/tau)
+	vector<double> populationGain; // tau (1 - exp(-dt/tau)), integral of the decay
+	vector<double> populationNoiseScale; // sigma sqrt(tau/2 (1 - exp(-2dt/tau)))
+	
+	// state, per cell
+	vector<double> populationVoltage; // current membrane voltage
+	vector<double> populationVoltageNext; // next membrane voltage
+	vector<double> populationValue; // current output, spike height during a spike
+	vector<double> populationValueNext; // next output
+	vector<char> populationEvent; // current spikes
+	vector<char> populationEventNext; // next spikes
+	vector<double> populationRefractory; // remaining refractory time
+	vector<double> populationConductance; // sum of conductances
+	vector<double> populationReversal; // sum of conductances times reversal potentials
+	vector<double> populationConductanceInput; // conductance added during this step
+	vector<double> populationReversalInput; // conductance times reversal potential added during this step
+	vector<double> populationNoise; // Gaussian numbers of one step
+	vector<uint> populationSpikes; // cells spiking now
+	vector<uint> populationSpikesNext; // cells spiking next
+	
+	// single-cell stimuli
+	vector<uint> populationStimulusCells; // cell of each stimulus
+	vector<StochasticFunction *> populationStimulusIntegrands; // integrand of each stimulus
+	vector<StochasticVariable *> populationStimulusIntegrators; // integrator of each stimulus
+	vector<StochasticProcess *> populationOwned; // integrands and integrators made here
+	
+	vector<TimeDependent *> populationInputs; // objects adding conductances
+	vector<PopulationNeuron *> populationViews; // views of single cells, 0 if not made
+	
+	/// Compute the coefficients of the exact step.
+	void updateCoefficients();
+	
+	// private copy constructor to prevent copying
+	IfNeuronPopulation( const IfNeuronPopulation & );
+	
+public:
+	/// Construct.
+	/** Creates a population of identical neurons, with the same parameters as IfNeuron. */
+	IfNeuronPopulation(
+		Time *time, ///< Time object stepping the population
+		uint size, ///< number of cells
+		double v0, ///< reset potential
+		double theta, ///< threshold potential
+		double spikeheight, ///< height of a spike in mV
+		double tau, ///< membrane time constant
+		double v_rest ///< resting potential
+	);
+	
+	/// Destroy.
+	virtual ~IfNeuronPopulation();
+	
+	/// Number of cells.
+	uint getSize() const { return populationSize; };
+	
+	/// Set the threshold of one cell.
+	void setThreshold( uint cell, double theta );
+	
+	/// Set the reset potential of one cell.
+	void setReset( uint cell, double v0 );
+	
+	/// Set resting potential and time constant of one cell.
+	void setLeak( uint cell, double v_rest, double tau );
+	
+	/// Set the white-noise drive of all cells.
+	void setDrive(
+		double mean, ///< mean input per time
+		double stddev ///< std. dev. of the input per square root of time
+	);
+	
+	/// Set the white-noise drive of one cell.
+	void setDrive( uint cell, double mean, double stddev );
+	
+	/// Set the refractory period of all cells.
+	/** After a spike the voltage is held at the reset value for this time, and at least for the step after the spike. The default is 0, i.e. the cell is held at reset for that one step and then integrates again, as IfNeuron without crossing correction. */
+	void setRefractoryPeriod( double period );
+	
+	/// Set the decay time constant of the synaptic conductances.
+	/** Conductances added by addConductance() decay exponentially with this time constant. The default is 5 ms. Use 0 for conductances which only last one step. */
+	void setSynapticTimeConstant( double tau );
+	
+	/// Add a conductance.
+	/** Increases the synaptic conductance of a cell by g, with reversal potential v. Called during prepareNextState() of an input object (see addInput()), the conductance takes effect in the same step. */
+	void addConductance( uint cell, double g, double v ) {
+		populationConductanceInput[cell] += g;
+		populationReversalInput[cell] += g * v;
+	};
+	
+	/// Register an object which adds conductances.
+	/** The population is stepped after it. SparseProjection does this itself. */
+	void addInput( TimeDependent *input );
+	
+	/// Add a stimulus to one cell.
+	/** The value is added purely onto the membrane potential, as IfNeuron::addStimulus(). */
+	int addStimulus( uint cell, StochasticVariable *integrator, double weight=1.0 );
+	
+	/// Add a stimulus with a reversal potential to one cell.
+	/** As IfNeuron::addStimulus(). */
+	int addStimulus( uint cell, StochasticVariable *integrator, double weight, double revpot );
+	
+	/// Add a synapse to one cell.
+	/** As IfNeuron::addStimulus(). */
+	int addStimulus( uint cell, Synapse *synapse );
+	
+	/// A view of one cell.
+	/** Made at the first call, and owned by the population. */
+	PopulationNeuron *getNeuron( uint cell );
+	
+	/// Current membrane voltages of all cells.
+	const double *getVoltages() const { return &populationVoltage[0]; };
+	
+	/// Current values of all cells.
+	/** The spike height during a spike, the membrane voltage otherwise. */
+	const double *getCurrentValues() const { return &populationValue[0]; };
+	
+	/// Next values of all cells.
+	const double *getNextValues() const { return &populationValueNext[0]; };
+	
+	/// Current spikes of all cells.
+	const char *getEvents() const { return &populationEvent[0]; };
+	
+	/// Next spikes of all cells.
+	const char *getNextEvents() const { return &populationEventNext[0]; };
+	
+	/// Cells which spike now.
+	const vector<uint> &getSpikes() const { return populationSpikes; };
+	
+	/// Objects this population depends on.
+	/** These are the inputs and the single-cell stimuli. */
+	virtual void getDependencies( vector<TimeDependent *> &dependencies );
+	
+	/// Reset all cells.
+	virtual void init();
+	
+	/// Calculate the next state of all cells.
+	virtual void prepareNextState();
+	
+	/// Advance all cells.
+	virtual void proceedToNextState();
+	
+	/// Whether the next state is prepared.
+	virtual bool isNextStatePrepared() { return populationNextStateIsPrepared; };
+};
+
+#endif
@@ -33,6 +33,7 @@ class IntervalEstimator: public ScalarEstimator
 {
 private:
 	int nTime;
+	double dOffset; // offset of the last event
 protected:
 	StochasticEventGenerator *pEvent;
 	const class Time *xTime; // time step size
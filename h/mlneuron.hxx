@@ -126,15 +126,24 @@ public:
 	~MlNeuron();
 	
 	/// Calibrate the neuron
-	/** Set the neuron to a specific reponse rate. This is achieved by internally adjusting the threshold.
+	/** Set the neuron to a specific reponse rate. This is achieved by internally adjusting the threshold (see SpikingNeuron::calibrateThreshold()).
 	If you do not give a NoiseSource object, all inputs to the neuron must be active for this to work. If the neuron receives passive processes (like correlated noise from a NoiseSource), you *must* give the address of the NoiseSource object driving them. */
 	void calibrate(
 		int isi, ///< Desired inter-spike interval, given in time steps.
-		int runs, ///< Number of runs used to estimate threshold. 50 is a good compromise.
-		int maxtime, ///< Maximum time for one run to take. 2*isi is a good compromise
+		int runs, ///< Maximal number of spikes used to estimate the interval. 50 is a good compromise.
+		int maxtime, ///< Maximum time for one batch of spikes to take. 10*isi is a good compromise
 		NoiseSource *noises = 0 ///< Address of a NoiseSource object.
 	);
 	
+	/// Start a calibration at the reset potential.
+	virtual void startCalibration(double &stepsize, double &precision);
+	
+	/// Return the threshold.
+	virtual double getThreshold() const { return mlneuronTheta; };
+	
+	/// Set the threshold.
+	virtual void setThreshold(double theta) { mlneuronTheta = theta; };
+	
 	/// Get parameter.
 	/** In a derived class, override this to handle every parameter you implement. If a parameter is described using multiple strings separated by space, this indicates a parameter of a parameter.  */
 	virtual string getParameter (
@@ -170,6 +179,10 @@ public:
 	/** This removes the nth stimulus from the differential equation */
 	virtual void removeStimulus( int n );
 	
+	/// Objects this neuron depends on.
+	/** This is the membrane equation. */
+	virtual void getDependencies( vector<TimeDependent *> &dependencies ) { dependencies.push_back(&mlneuronMembrane); };
+	
 	/// step
 	virtual void prepareNextState();
 };
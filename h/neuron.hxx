@@ -64,6 +64,34 @@ class SpikingNeuron: public Neuron, public StochasticEventGenerator
 		string name,   ///< object name
 		string type="Spiking Neuron"   ///< object type
 	) : Neuron(name, type), StochasticEventGenerator(time, name, type) {};
+	
+public:
+	/// Calibrate the threshold by stochastic approximation.
+	/** Drives the threshold to the value where the mean inter-spike interval matches the target, starting from the values given by startCalibration(). The threshold moves by the step size in the direction indicated by the measured interval, the step grows by the increment factor while the direction is kept and shrinks by the decrement factor when it turns (Kesten's rule for Robbins-Monro iterations). Each measurement is a sequential test: spikes are simulated in small batches and the run stops as soon as the target lies outside two standard errors of the mean interval. The sample size is capped at \f$ 5 s_0/s \f$ spikes for step size \f$ s \f$ and starting step size \f$ s_0 \f$, up to the given number of spikes, so the early iterations far from the solution cost a few spikes only. Calibration stops when the step size falls below the precision. Used by the calibrate() functions of the neuron classes and by Calibration, which runs the neuron on a Time object of its own. */
+	void calibrateThreshold(
+		int isi,   ///< desired inter-spike interval, given in time steps
+		int spikes,   ///< maximal number of spikes used for one measurement
+		int maxtime,   ///< maximal number of time steps for one batch of spikes
+		double increment = 1.1,   ///< factor used for increasing step size when direction is kept
+		double decrement = 0.8,   ///< factor used for decreasing step size when direction is changed
+		Time *time = 0,   ///< time object to run, the one of the neuron if 0
+		ostream &log = cout   ///< stream for progress messages
+	);
+	
+	/// Start a calibration.
+	/** Sets the threshold to its starting value and returns the starting step size and the step size at which calibrateThreshold() stops. */
+	virtual void startCalibration(
+		double &stepsize,   ///< starting step size of the threshold
+		double &precision   ///< step size at which to stop
+	) = 0;
+	
+	/// Return the threshold.
+	virtual double getThreshold() const = 0;
+	
+	/// Set the threshold.
+	virtual void setThreshold(
+		double theta   ///< new threshold
+	) = 0;
 };
 
 #endif
@@ -30,7 +30,7 @@ __________________________________________________________________________
 using namespace std;
 
 /// Inverse error function.
-/** This helper is needed for threshold estimation. */
+/** This helper is needed for threshold estimation. It uses Giles' rational approximation, polished with Newton steps on erf() (on the logarithm of erfc() in the tails, to avoid cancellation), and is accurate to a few units in the last place. Arguments outside of [-1, 1] return 0 with a message, -1 and 1 return -1e24 and 1e24. */
 double erfinv(double);
 
 
@@ -60,6 +60,10 @@ protected:
 	
 	virtual void setNext(double d) = 0;
 	
+	/// Update everything derived from the indicator variance.
+	/** Called by NoiseSource::reconfigure(). */
+	virtual void reconfigure() {};
+	
 public:
 	~Noise();
 	
@@ -73,6 +77,10 @@ public:
 		stochNextStateIsPrepared = true;
 	};
 	
+	/// Objects this noise depends on.
+	/** This is the noise source, which sets the values of this noise. */
+	virtual void getDependencies( vector<TimeDependent *> &dependencies );
+	
 	/// Set the weight.
 	virtual Noise &setWeight(double w);
 	
@@ -143,6 +151,9 @@ protected:
 	/** The main method. The NoiseSource class uses this to set the indicator values. If the indicator is above the current threshold, the value is set to w (the weight of the process), otherwise to 0.0. */
 	virtual void setNext(double indicator);
 	
+	/// Recompute the threshold.
+	virtual void reconfigure() { setThreshold(); };
+	
 public:
 	~PoissonNoise();
 	
@@ -187,6 +198,89 @@ protected:
 public:
 	~WienerNoise();
 	
+	/// Quadratic variation of one step.
+	/** This is \f$\sigma^2\Delta t\f$. */
+	virtual double getQuadraticVariation() { return noiseSigma * noiseSigma * xTime->dt; };
+	
+friend class NoiseSource;
+};
+
+
+/// An Ornstein-Uhlenbeck (coloured) noise source.
+/** Internal class: Apart from the time constant, all public members are defined in Noise. This noise is the integral of an Ornstein-Uhlenbeck process
+\f[ d\eta_t = -\frac{\eta_t-\mu}{\tau}dt + \frac{\sigma}{\tau}dW_t, \f]
+so it can be used as a stochastic variable in a differential equation just like WienerNoise, and approaches the Wiener process \f$\mu t+\sigma W_t\f$ for \f$\tau\to 0\f$. For indicators of unit variance the current \f$\eta\f$ has stationary mean \f$\mu\f$ and variance \f$\sigma^2/2\tau\f$. It is advanced with the exact AR(1) update
+\f[ \eta_{t+\Delta} = \mu + e^{-\Delta/\tau}(\eta_t-\mu) + \frac{\sigma}{\sqrt{2\tau}}\sqrt{1-e^{-2\Delta/\tau}}\;\omega, \f]
+where \f$\omega\f$ is the indicator (see NoiseSource), so any time step is stable and no separate DifferentialEquation is needed to colour a Wiener process. The integral uses the trapezoidal rule. The first indicator draws \f$\eta\f$ from the stationary distribution. Being of finite variation, the quadratic variation of this process vanishes. */
+
+class OUNoise: public Noise
+{
+private:
+	double ouTau; // time constant
+	double ouCurrent; // the Ornstein-Uhlenbeck process eta
+	double ouDecay; // exp(-dt/tau)
+	double ouSpread; // stationary standard deviation of eta
+	double ouScale; // standard deviation of the innovation
+	bool ouStarted; // whether eta has been drawn
+	void setCoefficients();
+	
+protected:
+	/// Construct.
+	/** This constructor is protected, because this class can only be instantiated by calls from the NoiseSource class. */
+	OUNoise(class NoiseSource *parent, int index, const string& name="", const string& type="Correlated Ornstein-Uhlenbeck Process");
+	
+	/// Construct.
+	/** This class mustn't be copied. */
+	OUNoise( const OUNoise & );
+	
+	/// Set the next values.
+	/** \param indicator The stochastic indicator.
+	This is the main method. The NoiseSource class uses this to advance the current \f$\eta\f$ and its integral. */
+	virtual void setNext(double indicator);
+	
+public:
+	~OUNoise();
+	
+	/// Initialise.
+	/** Sets the integral to zero. The next indicator draws \f$\eta\f$ again from the stationary distribution, so each run starts afresh. */
+	virtual void init();
+	
+	/// Set the time constant.
+	/** Can also be set with the parameter "tau". The default is 1.0. */
+	Noise &setTau(double tau);
+	
+	/// Get the time constant.
+	double getTau() { return ouTau; };
+	
+	/// Get the current.
+	/** This is the Ornstein-Uhlenbeck process \f$\eta\f$ itself, i.e. the derivative of this process. */
+	double getCurrent() { return ouCurrent; };
+	
+	/// Set the rate.
+	virtual Noise &setRate(double r);
+	
+	/// Set the weight.
+	virtual Noise &setWeight(double w);
+	
+	/// Set the mean.
+	virtual Noise &setMean(double m);
+	
+	/// Set the standard deviation coefficient.
+	virtual Noise &setStdDev(double s);
+	
+	/// Set parameter.
+	/** Implements "tau". */
+	virtual void setParameter (
+		const string& name,   ///< name of parameter
+		const string& value   ///< value of parameter (used with operator<<)
+	);
+	
+	/// Get parameter.
+	/** Implements "tau". */
+	virtual string getParameter (
+		const string& name   ///< name of parameter
+	) const;
+	
 friend class NoiseSource;
 };
 
@@ -208,12 +302,36 @@ with
 class NoiseSource: public StochasticProcess, public RandN
 {
 public:
+	/// Storage of the mixing matrix.
+	enum MixingMode {
+		MIXING_DENSE,   ///< full matrix
+		MIXING_LOWER,   ///< lower triangular matrix, f.i. a Cholesky factor
+		MIXING_LOW_RANK,   ///< shared factors plus private noise
+		MIXING_SPARSE   ///< sparse matrix in compressed rows
+	};
+	
 //	private:
-	// for perfomance reasons we'll use normal arrays only.
-	double *aOmega; // first indicator variables
-	double **aA; // the mixing matrix
+	// for perfomance reasons all matrices are contiguous arrays, stored by columns unless sparse.
+	vector<double> aOmega; // independent normal variables, nNoises + nRank
+	vector<double> aIndicators; // mixed indicator variables
+	vector<double> aA; // the mixing matrix, or its lower triangle, or the shared factors, or the sparse values
+	vector<double> aDiagonal; // weights of the private noise (low rank mode)
+	vector<double> aVariances; // variances of the indicators
+	vector<uint> aRows; // first entry of each row, and the end (sparse mode)
+	vector<uint> aColumns; // column of each entry (sparse mode)
 	class Noise **aNoises; // the noise objects
 	int nNoises; // number of noises in arrays
+	int nRank; // number of shared factors (low rank mode)
+	MixingMode nMixing; // storage of the mixing matrix
+	
+	/// Allocate the arrays for n noises, with an identity mixing matrix.
+	void allocate( int n );
+	
+	/// Read a mixing matrix, checking its dimensions.
+	bool readMatrix( Matrix &a, int columns, vector<double> &values, const char *caller );
+	
+	/// Mix the independent variables into the indicators.
+	void mix();
 	
 public:
 	/// Construct.
@@ -247,14 +365,46 @@ public:
 	);
 		
 	/// Set the mixing matrix.
-	/** Just sets a new mixing matrix to a given set of noises. Note that the dimensions of the matrix must match (i.e. for n noise sources, you want an nxn Matrix. */
+	/** Just sets a new mixing matrix to a given set of noises. Note that the dimensions of the matrix must match (i.e. for n noise sources, you want an nxn Matrix. The matrix is stored in the cheapest form matching its structure: sparse if at most a quarter of the entries is non-zero, lower triangular if all entries above the diagonal vanish, dense otherwise. Mixing then costs the number of non-zero entries, n(n+1)/2 or n^2 multiplications per step. */
 	void setMixingMatrix(
 		Matrix a ///< The mixing matrix.
 	);	
 	
+	/// Set a sparse mixing matrix.
+	/** Entry i of the lists is the element (rows[i], columns[i]) of the matrix, entries which are not given are zero. The lists are sorted into compressed rows with a counting sort, so mixing costs one multiplication per entry, and no dense matrix needs to be built for thousands of noises. */
+	void setMixingMatrix(
+		const vector<uint> &rows, ///< row of each entry
+		const vector<uint> &columns, ///< column of each entry
+		const vector<double> &values ///< value of each entry
+	);
+	
+	/// Set shared factors plus private noise.
+	/** The indicators are \f[ \omega_i = \sum_{k=1}^K F_{ik}\xi_k + d_i\eta_i, \f] with K shared and n private independent normal variables, so their covariance is \f$ FF^T + \mbox{diag}(d^2) \f$. This is the structure of common-input models, and costs n(K+1) multiplications per step instead of n^2. */
+	void setMixingFactors(
+		Matrix factors, ///< nxK matrix of shared factors F
+		const vector<double> &diagonal ///< weight d of the private noise of each indicator
+	);
+	
+	/// Set the covariance of the indicators.
+	/** The mixing matrix is the lower triangular Cholesky factor of the given symmetric, positive definite nxn matrix. */
+	void setCovarianceMatrix(
+		Matrix c ///< The covariance matrix.
+	);
+	
+	/// Get the storage of the mixing matrix.
+	MixingMode getMixingMode() const { return nMixing; };
+	
+	/// Get covariance of two indicators.
+	double getIndicatorCovariance( int n, int m );
+	
 	/// Get variance.
+	/** The variances are computed once for each mixing matrix, so this is a lookup. */
 	double getIndicatorVariance( int n );
 	
+	/// Recompute everything derived from the mixing matrix.
+	/** Computes the variances of all indicators in one pass over the mixing matrix, and then the thresholds of all Poisson noises. This is called whenever the mixing matrix changes, so it is only needed after changing the time step. */
+	void reconfigure();
+	
 	/// Get covariation coefficient.
 	/** The covariation process (see Covariation) is in many cases just time multiplied by a scalar. The method retrieves this scalar. 
 	\returns The scalar s, so that \f$ \left[X^n,X^m\right]_t = st\f$*/
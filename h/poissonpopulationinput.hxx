@@ -0,0 +1,92 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#ifndef POISSONPOPULATIONINPUT_HXX
+#define POISSONPOPULATIONINPUT_HXX
+
+#include "stochastic.hxx"
+
+using namespace std;
+
+/// The summed input of a population of Poisson processes.
+/** This is the jump process which WienerCpp approximates by a Wiener process: the weighted sum of n Poisson processes of rate \f$\lambda\f$ and weight w, with coincident events of relative width \f$n_{rc}\f$ and relative rate \f$\lambda_{rc}\f$ (see WienerCpp for the parametrisation). The events split into two independent Poisson processes,
+    - single events of weight w, with the total rate \f$ n\lambda(1-n_{rc}\lambda_{rc}) \f$,
+    - coincident events of weight \f$ nn_{rc}w \f$, with the rate \f$ \lambda_{rc}\lambda \f$,
+
+so mean and variance are the same as in WienerCpp, but the process keeps its jumps. Each step draws the number of events of both processes with RandN::nRandP(), so the cost does not depend on the number of processes n. If the single weights are spread (see setWeightDeviation()), the sum of the k weights in one step is drawn as one normal variable with mean kw and variance \f$k\sigma_w^2\f$.
+    The object can be used in place of n Poisson objects and their synapses, or of a WienerCpp object, as a stochastic variable in a differential equation (see IfNeuron::addStimulus()). Parameters are the same as in WienerCpp, plus "weight-deviation". */
+class PoissonPopulationInput: public RandN, public StochasticVariable
+{
+private:
+	double populationW; // single weight
+	double populationN; // number of processes
+	double populationLambda; // single rate
+	double populationCoincWidth; // relative coincidence width
+	double populationCoincRate; // relative coincidence rate
+	double populationWeightDev; // standard deviation of the single weights
+	double populationSingleMean; // expected number of single events per step
+	double populationCoincMean; // expected number of coincident events per step
+	double populationCoincWeight; // weight of a coincident event
+	double populationDelta; // sum of the events in the last step
+	
+	/// Compute the expected number of events per step from the parameters.
+	void updateRates();
+	
+public:
+	/// Constructor.
+	/** \param time Time object
+		\param w single weight 
+		\param n number of processes in the sum of processes 
+		\param lambda rate of a single process
+		\param n_rc relative coincidence width
+		\param lambda_rc relative coincidence rate */
+	PoissonPopulationInput(class Time *time, double w, double n, double lambda, double n_rc=0.0, double lambda_rc=0.0, const string& name="", const string& type="Poisson Population Input");
+	~PoissonPopulationInput();
+	
+	/// Initialise.
+	/** Computes the expected number of events per step from the parameters, and sets the value to zero. */
+	virtual void init();
+	
+	/// Calculate next value.
+	virtual void prepareNextState();
+	
+	/// Set the spread of the single weights.
+	/** The weights of the single events are then normally distributed, with mean w and the given standard deviation. Coincident events keep the weight \f$ nn_{rc}w \f$. Can also be set with the parameter "weight-deviation". */
+	void setWeightDeviation( double deviation );
+	
+	/// Mean per time.
+	/** This is \f$ nw\lambda \f$, as in WienerCpp. */
+	double getMean();
+	
+	/// Variance per time.
+	/** This is \f$ \left(n\lambda(1-n_{rc}\lambda_{rc})(w^2+\sigma_w^2) + \lambda_{rc}\lambda(nn_{rc}w)^2\right) \f$, which is the variance of WienerCpp for \f$ \sigma_w=0 \f$. */
+	double getVariance();
+	
+	/// Sum of the events in the last step.
+	double getDelta() { return populationDelta; };
+	
+	virtual string getParameter(const string& p) const;
+	virtual void setParameter(const string& p, const string& d);
+};
+
+#endif
@@ -0,0 +1,159 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#ifndef POPULATION_DENSITY_HXX
+#define POPULATION_DENSITY_HXX
+
+#include "differentiable.hxx"
+#include "estimator.hxx"
+#include "matrix.hxx"
+
+using namespace std;
+
+class IfNeuron;
+class ThetaNeuron;
+
+/// Fokker-Planck solver for the membrane density of a neuron.
+/** Instead of simulating many spikes, this class solves the Fokker-Planck equation of the membrane, \f[ \partial_t p = -\partial_x (A p) + \partial_x^2 (D p), \f] on a grid between a lower bound and the threshold. Drift \f$A\f$ and diffusion \f$D\f$ are read from the terms of the membrane equation: a term with a TimeProcess contributes its integrand \f$f(x)\f$ to the drift, a term with a Wiener process contributes \f$f(x)\mu\f$ to the drift and \f$\frac{1}{2}f(x)^2\sigma^2\f$ to the diffusion (plus \f$\frac{1}{2}f f'\sigma^2\f$ to the drift in Stratonovich mode). Other terms, including synapses, are ignored with a message; replace them by their mean and Wiener noise first. The density is absorbed at the threshold, reflected at the lower bound, and the outflow is put back at the reset potential.
+    The grid is a finite volume grid with Scharfetter-Gummel fluxes, which keep the density positive and stay exact for strong drift, so also regions without noise (as the spike of a ThetaNeuron) are handled. Stationary density, rate and the moments of the intervals are found by direct tridiagonal solves. Interval densities and spike-triggered averages follow the density in time with the Crank-Nicolson scheme, started with a few implicit half steps to damp the kink of the initial density, with the time step of the neuron.
+    The results have the shapes the estimators return: interval moments as IntervalEstimator, densities as ScalarEstimator with EST_DENS, and triggered averages as ConditionalEstimator. The model is continuous in time, so it matches a simulation with small time steps, or an IfNeuron with crossing correction (see IfNeuron::setCrossingCorrection()), which has no dead step after a spike. The terms are read at construction and by update(). */
+class PopulationDensity
+{
+private:
+	DifferentialEquation *densityEquation; // the membrane equation
+	double densityDt; // time step of the neuron
+	bool densityValid; // whether the threshold is reached
+	
+	// terms
+	bool densityStratonovich; // integration mode
+	vector<StochasticFunction *> densityIntegrands; // integrand of each term used
+	vector<double> densityDrifts; // drift per unit time of each integrator
+	vector<double> densityVariances; // variance per unit time of each integrator
+	
+	// grid
+	uint densityCells; // number of cells
+	double densityLower; // lower bound
+	double densityThreshold; // threshold, absorbing upper bound
+	double densityReset; // reset potential
+	double densityWidth; // width of a cell
+	uint densityResetCell; // cell receiving the outflow
+	
+	// operator on the cell masses, the flux from cell i to i+1 is densityUp[i]*m[i] - densityDown[i]*m[i+1]
+	vector<double> densityUp; // upward rate of each inner face
+	vector<double> densityDown; // downward rate of each inner face
+	double densityOut; // rate of the outflow through the threshold
+	
+	// Crank-Nicolson system (1 - dt/2 L), factorised once
+	vector<double> densityPivots; // diagonal after elimination
+	vector<double> densityFactors; // elimination factors
+	vector<double> densityReinjection; // the system solved for the reinjection, for Sherman-Morrison
+	
+	// stationary state
+	vector<double> densityStationary; // mass of each cell
+	double densityRate; // firing rate
+	double densityMeanInterval; // first moment of the interval
+	double densitySecondInterval; // second moment of the interval
+	
+	// range of interval densities
+	int densityBins;
+	double densityRange[2];
+	
+	/// Read the terms of the equation.
+	void compile();
+	
+	/// Set up the grid, the operator and the stationary state.
+	void build();
+	
+	/// Drift and diffusion at a point.
+	void getCoefficients( double x, double &drift, double &diffusion );
+	
+	/// Solve \f$ -L_a y = b \f$, with \f$L_a\f$ the operator without reinjection.
+	void solveAbsorbed( const vector<double> &b, vector<double> &y );
+	
+	/// Solve the factorised Crank-Nicolson system.
+	void solveStep( vector<double> &m );
+	
+	/// Advance masses by one step.
+	/** A Crank-Nicolson step, or an implicit step of half the size if implicit is set. Returns the outflow during the step. */
+	double step( vector<double> &m, bool reinject, bool implicit );
+	
+	// private copy constructor to prevent copying
+	PopulationDensity( const PopulationDensity & );
+	
+public:
+	/// Construct from an integrate-and-fire neuron.
+	/** The lower bound is placed six standard deviations of the free membrane below the reset potential or the resting point, whichever is lower. */
+	PopulationDensity(
+		IfNeuron *neuron,   ///< the neuron
+		uint cells = 400   ///< number of grid cells
+	);
+	
+	/// Construct from a theta neuron.
+	/** The grid spans \f$[-\pi, \pi]\f$, the outflow at \f$\pi\f$ comes back at \f$-\pi\f$. */
+	PopulationDensity(
+		ThetaNeuron *neuron,   ///< the neuron
+		uint cells = 400   ///< number of grid cells
+	);
+	
+	/// Construct from an equation.
+	PopulationDensity(
+		DifferentialEquation *equation,   ///< the membrane equation
+		double lower,   ///< lower bound of the grid, reflecting
+		double threshold,   ///< threshold, absorbing
+		double reset,   ///< the outflow is put back here
+		uint cells = 400   ///< number of grid cells
+	);
+	
+	/// Read the terms again.
+	/** Call this after parameters of the equation or its Wiener processes changed. */
+	void update();
+	
+	/// Whether the threshold is reached.
+	bool isValid() const { return densityValid; };
+	
+	/// Stationary firing rate.
+	/** Number of spikes per unit time. */
+	double getRate() const { return densityRate; };
+	
+	/// Set distribution-related properties.
+	/** As ScalarEstimator::setProperty(), for the interval density. The default range is 0 to five mean intervals, in 100 bins. */
+	void setProperty( const Property&, double );
+	
+	/// Inter-spike intervals.
+	/** EST_MEAN and EST_VAR as a 1x1 matrix, EST_DENS as bins x 2 matrix of interval and density, as IntervalEstimator returns them. */
+	Matrix getIntervals( const Property &property );
+	
+	/// Stationary membrane potential.
+	/** EST_MEAN and EST_VAR as a 1x1 matrix, EST_DENS as cells x 2 matrix of potential and density. */
+	Matrix getPotentials( const Property &property );
+	
+	/// Spike-triggered membrane potential.
+	/** EST_MEAN or EST_VAR of the membrane potential from pre time steps before to post time steps after a spike, as a graph of time and value, as ConditionalEstimator returns it. Lag 0 is the reset potential. Later spikes are included, as in ConditionalEstimator without rejection. */
+	Matrix getTriggered(
+		const Property &property,   ///< EST_MEAN or EST_VAR
+		int pre,   ///< number of time steps before the spike
+		int post   ///< number of time steps after the spike
+	);
+};
+
+#endif
@@ -26,6 +26,8 @@ __________________________________________________________________________
 
 #include "differentiable.hxx"
 #include "stochastic.hxx"
+#include "function.hxx"
+#include "matrix.hxx"
 
 class StochasticProcess;
 class StochasticVariable;
@@ -93,6 +95,16 @@ public:
 	virtual double calculateNextValue() {
 		return scalarValue;
 	};
+	
+	/// Derivative, zero.
+	virtual double getDerivative(double x) { return 0.0; };
+	
+	/// Affine form, the value.
+	virtual bool getAffine(double &offset, double &slope) {
+		offset = scalarValue;
+		slope = 0.0;
+		return true;
+	};
 };
 
 /// A product of the function input and a scalar.
@@ -115,6 +127,16 @@ public:
 	/// Return next product value.
 	virtual double calculateNextValue();
 	
+	/// Derivative, the factor.
+	virtual double getDerivative(double x) { return productFactor; };
+	
+	/// Affine form, the factor.
+	virtual bool getAffine(double &offset, double &slope) {
+		offset = 0.0;
+		slope = productFactor;
+		return true;
+	};
+	
 	/// Get parameter.
 	/** Implements "value". */
 	virtual string getParameter(const string& name) const;
@@ -140,6 +162,12 @@ public:
 	virtual double calculateCurrentValue() {
 		return stochCurrentValue*stochCurrentValue*productFactor;
 	};
+	
+	/// Derivative, twice the factor times the input.
+	virtual double getDerivative(double x) { return 2.0*x*productFactor; };
+	
+	/// Not affine.
+	virtual bool getAffine(double &offset, double &slope) { return false; };
 };
 
 /// returns a product of a difference of Xt
@@ -169,14 +197,29 @@ public:
 	
 	/// Generate next value.
 	virtual double calculateNextValue();
+	
+	/// Derivative, minus the weight.
+	virtual double getDerivative(double x) { return -dWeight; };
+	
+	/// Affine form, weight * reversal - weight * x.
+	virtual bool getAffine(double &offset, double &slope) {
+		offset = dWeight * dReversal;
+		slope = -dWeight;
+		return true;
+	};
 };
 
 /// Returns delta peaks with a static rate.
-/** Poisson process: steps forward when using either () or (double) operators. */
+/** Poisson process: steps forward when using either () or (double) operators. In each time step an event happens with the probability \f$\lambda\Delta t\f$, independently of the other steps. Instead of drawing this decision in every step, the number of steps up to the next event is drawn from the matching geometric distribution, \f[ K = 1 + \left\lfloor \frac{\ln U}{\ln(1-\lambda\Delta t)} \right\rfloor, \f] so the events are distributed exactly as before, but a step without event only costs a decrement. */
 class Poisson: public StochasticEventGenerator, RandN
 {
 private:
 	double poissonRate;
+	long poissonWait; // steps up to and including the next event, 0 if not drawn
+	unsigned long long poissonEpoch; // random epoch of the time object the wait was drawn in
+	
+	/// Draw the steps up to the next event.
+	void drawWait();
 
 public:
 	
@@ -192,6 +235,13 @@ public:
 	/// Calculate next time value.
 	virtual void prepareNextState();
 	
+	/// Initialise.
+	/** The next event is drawn again. */
+	virtual void init();
+	
+	/// Get the rate.
+	double getRate() { return poissonRate / xTime->dt; };
+	
     /// Get parameter.
 	virtual string getParameter(const string& name) const;
 	
@@ -200,6 +250,62 @@ public:
 };
 
 
+/// Returns delta peaks with a time dependent rate.
+/** Inhomogeneous Poisson process, made by Lewis-Shedler thinning: candidate events are drawn like in Poisson with the maximal rate \f$\lambda_{max}\f$, and each candidate at time t is kept with the probability \f$\lambda(t)/\lambda_{max}\f$. Events are thus distributed exactly as if an event was drawn in each step with the probability \f$\lambda(t)\Delta t\f$, but the rate is only evaluated at candidate events. The rate is either a Function of the time (its x input), or a table of times and rates which is interpolated linearly, and is constant outside of the table. */
+class InhomogeneousPoisson: public StochasticEventGenerator, RandN
+{
+private:
+	Function *inhomRate; // rate as function of time, if given
+	vector<double> inhomTimes; // times of the rate table
+	vector<double> inhomRates; // rates of the rate table
+	uint inhomIndex; // table entry at or before the last candidate
+	double inhomMax; // candidate probability per step
+	long inhomWait; // steps up to and including the next candidate, 0 if not drawn
+	unsigned long long inhomEpoch; // random epoch of the time object the wait was drawn in
+	bool inhomWarned; // whether the rate exceeded the maximum
+	
+	/// Draw the steps up to the next candidate.
+	void drawWait();
+	
+	/// Rate at time t.
+	double getRate( double t );
+
+public:
+	
+	/// Create with a rate function.
+	/** The rate must stay below the given maximum, otherwise it is cut off there (with a message). */
+	InhomogeneousPoisson(
+		Function &rate,   ///< rate, as a function of time (x input)
+		double maxRate,   ///< maximum of the rate
+		Time *time,   ///< time object
+		const string& name="",
+		const string& type="Inhomogeneous Poisson process"
+	);
+	
+	/// Create with a rate table.
+	/** The maximum rate is the maximum of the table. */
+	InhomogeneousPoisson(
+		Matrix profile,   ///< nx2 matrix, times in the first column, rates in the second
+		Time *time,   ///< time object
+		const string& name="",
+		const string& type="Inhomogeneous Poisson process"
+	);
+	
+	/// Destroy.
+	~InhomogeneousPoisson(){};
+	
+	/// Calculate next time value.
+	virtual void prepareNextState();
+	
+	/// Initialise.
+	/** The next candidate is drawn again. */
+	virtual void init();
+	
+	/// The rate is taken at the time passed.
+	virtual bool readsTimePassed() { return true; };
+};
+
+
 /// Returns delta peaks with a static rate.
 /** Poisson process: steps forward when using either () or (double) operators. */
 class Regular: public StochasticEventGenerator
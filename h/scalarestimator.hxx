@@ -44,6 +44,7 @@ public:
 	virtual void collect(); ///< Eat next piece of data
 	virtual void init(); ///< reset all values
 	virtual Matrix getEstimate(const Property&); ///< return result of estimation
+	virtual void merge(Estimator *); ///< add data of another scalar estimator
 	ScalarEstimator(const Property&, StochasticProcess *, Time *); ///< Constructor
 	void setProperty( const Property&, double ); ///< set distribution-related properties
 	virtual ~ScalarEstimator(); ///< Destructor
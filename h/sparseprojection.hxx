@@ -0,0 +1,140 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#ifndef SPARSEPROJECTION_HXX
+#define SPARSEPROJECTION_HXX
+
+#include "timedependent.hxx"
+#include "calendar.hxx"
+#include <vector>
+
+using namespace std;
+
+class IfNeuronPopulation;
+
+/// Synaptic connections from one population to another.
+/** The connections are stored in compressed sparse rows (CSR): for each cell of the source population, the range of its outgoing edges, and for each edge the target cell, the weight (a conductance) and the reversal potential. When a source cell spikes, the projection pushes the conductances along its row into the target population (see IfNeuronPopulation::addConductance()), so the cost of one step is the number of spikes times their fan-out, not the number of synapses. Nothing is polled, and cells which don't spike cost nothing.
+    Spikes of the current step take effect in the next step of the target, and decay there with its synaptic time constant. Each edge can have an axonal delay of a whole number of time steps. Within a row the edges are sorted by delay, and a spike schedules each group of equal delay once in a Calendar shared by the whole projection, so a spike costs one entry per distinct delay, and delivery costs one visit per arriving edge. */
+class SparseProjection: public TimeDependent
+{
+private:
+	IfNeuronPopulation *projectionSource; // pre-synaptic population
+	IfNeuronPopulation *projectionTarget; // post-synaptic population
+	vector<uint> projectionRows; // first edge of each source cell, and the end
+	vector<uint> projectionTargets; // target cell of each edge
+	vector<double> projectionWeights; // conductance of each edge
+	vector<double> projectionReversals; // reversal potential of each edge
+	vector<uint> projectionDelays; // delay of each edge, in time steps
+	vector<uint> projectionRowSegments; // first group of equal delay of each source cell, and the end
+	vector<uint> projectionSegments; // first edge of each group, and the end
+	vector<uint> projectionSegmentDelays; // delay of each group
+	Calendar<uint> projectionCalendar; // groups on their way
+	bool projectionNextStateIsPrepared;
+	
+	/// Sort the edge lists into rows, and each row by delay.
+	void build(const vector<uint> &pre, const vector<uint> &post, const vector<double> &weights, const vector<double> &reversals, const vector<uint> &delays);
+	
+	// private copy constructor to prevent copying
+	SparseProjection( const SparseProjection & );
+	
+public:
+	/// Construct from edge lists.
+	/** Edge i connects source cell pre[i] to target cell post[i], with a weight and a reversal potential, and no delay. The lists are sorted into rows with a counting sort, in O(E) time. Within a row the edges keep their order. */
+	SparseProjection(
+		Time *time, ///< Time object
+		IfNeuronPopulation *source, ///< pre-synaptic population
+		IfNeuronPopulation *target, ///< post-synaptic population
+		const vector<uint> &pre, ///< source cell of each edge
+		const vector<uint> &post, ///< target cell of each edge
+		const vector<double> &weights, ///< conductance of each edge
+		const vector<double> &reversals ///< reversal potential of each edge
+	);
+	
+	/// Construct from edge lists.
+	/** The same, with one reversal potential for all edges, f.i. for a purely excitatory or inhibitory projection. */
+	SparseProjection(
+		Time *time, ///< Time object
+		IfNeuronPopulation *source, ///< pre-synaptic population
+		IfNeuronPopulation *target, ///< post-synaptic population
+		const vector<uint> &pre, ///< source cell of each edge
+		const vector<uint> &post, ///< target cell of each edge
+		const vector<double> &weights, ///< conductance of each edge
+		double reversal ///< reversal potential of all edges
+	);
+	
+	/// Construct from edge lists with delays.
+	/** The same, with an axonal delay for each edge, in time steps. A spike of the current step reaches the target with a delay of 0 in the next step, as without delays, and with a delay of d, d steps later. The edges are sorted by source cell and delay with two counting sorts, in O(E + N + D) time. */
+	SparseProjection(
+		Time *time, ///< Time object
+		IfNeuronPopulation *source, ///< pre-synaptic population
+		IfNeuronPopulation *target, ///< post-synaptic population
+		const vector<uint> &pre, ///< source cell of each edge
+		const vector<uint> &post, ///< target cell of each edge
+		const vector<double> &weights, ///< conductance of each edge
+		const vector<double> &reversals, ///< reversal potential of each edge
+		const vector<uint> &delays ///< delay of each edge, in time steps
+	);
+	
+	/// Destroy.
+	virtual ~SparseProjection() {};
+	
+	/// Number of edges.
+	uint getEdges() const { return projectionTargets.size(); };
+	
+	/// First edge of a source cell.
+	/** The edges of cell i are getRowBegin(i) .. getRowBegin(i+1)-1. */
+	uint getRowBegin( uint cell ) const { return projectionRows[cell]; };
+	
+	/// Target cell of an edge.
+	uint getTarget( uint edge ) const { return projectionTargets[edge]; };
+	
+	/// Weight of an edge.
+	double getWeight( uint edge ) const { return projectionWeights[edge]; };
+	
+	/// Set the weight of an edge.
+	void setWeight( uint edge, double weight ) { projectionWeights[edge] = weight; };
+	
+	/// Reversal potential of an edge.
+	double getReversal( uint edge ) const { return projectionReversals[edge]; };
+	
+	/// Delay of an edge, in time steps.
+	uint getDelay( uint edge ) const { return projectionDelays[edge]; };
+	
+	/// Objects this projection reads.
+	/** This is the source population. */
+	virtual void getInputs( vector<TimeDependent *> &inputs );
+	
+	/// Schedule the spikes of all spiking source cells, push the conductances which arrive.
+	virtual void prepareNextState();
+	
+	/// Go to the next slot of the calendar.
+	virtual void proceedToNextState();
+	
+	/// Drop all spikes on their way.
+	virtual void init();
+	
+	/// Whether the next state is prepared.
+	virtual bool isNextStatePrepared() { return projectionNextStateIsPrepared; };
+};
+
+#endif
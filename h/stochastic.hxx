@@ -24,11 +24,10 @@ __________________________________________________________________________
 #ifndef STOCHASTIC_HXX
 #define STOCHASTIC_HXX
 
-#include <boost/random/mersenne_twister.hpp>
-#include <boost/random/uniform_real_distribution.hpp>
 #include <iostream>
 #include <cmath>
 #include <vector>
+#include <stdint.h>
 
 #include "physical.hxx"
 #include "parametric.hxx"
@@ -83,11 +82,19 @@ public:
 		return stochNextStateIsPrepared;
 	}
 	
+	/// Whether the step being taken changes the value.
+	/** Processes whose readers use more than the value must override this. */
+	virtual bool isChanging() { return stochNextValue != stochCurrentValue; };
+	
 	/// Returns the increment.
 	/** This is the difference to the next time step. The difference to
 	operator()() is that it never proceeds the object's time. */
 	virtual double getIncrement() { return stochNextValue - stochCurrentValue; };
 	
+	/// Returns the expected quadratic variation of the current increment.
+	/** This is the variance of the continuous martingale part accumulated during one time step, e.g. \f$\sigma^2\Delta t\f$ for a Wiener process. Higher-order schemes in DifferentialEquation use it to find the diffusive terms. The default returns 0.0, which is right for processes of finite variation. */
+	virtual double getQuadraticVariation() { return 0.0; };
+	
 	/// Returns the value of the process.
 	/** This is the current value. The difference to
 	operator()(double) is that it never proceeds the object's time. Implementing this function is compulsary.  */
@@ -201,6 +208,19 @@ public:
 	
 	/// Calculates the next value based on the current input.
 	virtual double calculateNextValue() = 0;
+	
+	/// Derivative of the function.
+	/** Returns \f$f'(x)\f$, used by the Milstein scheme in DifferentialEquation. The default takes a central difference, override this if the derivative is known in closed form. */
+	virtual double getDerivative(double x) {
+		double h = 1e-6 * (1.0 + fabs(x));
+		double derivative = (getCurrentValue(x + h) - getCurrentValue(x - h)) / (2.0 * h);
+		getCurrentValue(x);
+		return derivative;
+	}
+	
+	/// Affine form of the function.
+	/** If the function is affine in its input, f(x) = offset + slope * x, this sets both coefficients and returns true. Used by code that evaluates the function for many inputs at once. The default returns false. */
+	virtual bool getAffine(double &offset, double &slope) { return false; }
 };
 
 
@@ -211,12 +231,14 @@ class StochasticEventGenerator : public StochasticVariable
 protected:
     bool eventCurrentValue;
     bool eventNextValue;
+    double eventCurrentOffset;
+    double eventNextOffset;
     
 public:
 	
 	/// Create.
     StochasticEventGenerator(class Time *time, const string& name="", const string& type="Event Generator")
-        : StochasticVariable( time, name, type) {}
+        : StochasticVariable( time, name, type) { eventCurrentValue = eventNextValue = false; eventCurrentOffset = eventNextOffset = 0.0; }
 	
 	/// Destroy.
     virtual ~StochasticEventGenerator() {}
@@ -224,41 +246,107 @@ public:
 	/// Whether an event is present.
     virtual bool hasEvent() { return eventCurrentValue; }
 
+	/// Whether the step being taken changes the value or the event.
+    virtual bool isChanging() { return eventNextValue != eventCurrentValue || StochasticVariable::isChanging(); }
+
 	/// The amount of events present.
     virtual uint getEventAmount() { return eventCurrentValue ? 1 : 0; }
+
+	/// How long before the current time step the event happened.
+	/** Given as a fraction of the time step between 0 and 1. Generators which locate events between time steps (see IfNeuron::setCrossingCorrection()) set it, the default is 0, i.e. the event happened at the time step. Used by IntervalEstimator. */
+    virtual double getEventOffset() { return eventCurrentOffset; }
     
     /// Proceed one time step
     virtual void proceedToNextState();
 };
 
 /// An object which uses the randn function.
-/** This class implements a random variable with normal distribution (gaussian). */
+/** This class implements a random variable with normal distribution (gaussian). Each object owns an independent stream of random numbers, generated by the counter-based Philox4x32-10 generator. The stream is keyed by the seed of the Time object, the run number of the Time object, and a stream number which the Time object hands out in order of construction. Networks built in the same order on Time objects with the same seed therefore draw the same numbers, no matter in which thread they run, and a run can be replayed by setting its run number (see Time::setSeed() and Time::setRun()). */
 class RandN
 {
 private:
-	static uint32_t nState;
-	static uint nRefs;
-	static boost::random::mt19937_64 *randGenerator;
-	static boost::random::uniform_real_distribution<double> dist;
+	static uint64_t nDefaultSeed; // seed for streams without own seed
+	static uint nDefaultStreams; // stream counter for objects without a time object
+	
+	class Time *randTime; // time object providing seed and run number
+	uint randStream; // stream number
+	uint64_t randEpoch; // epoch of the time object the stream was keyed in
+	uint32_t randKey[2]; // generator key (seed)
+	uint32_t randRun; // run number, part of the generator counter
+	uint64_t randBlockNumber; // next block of the stream, part of the generator counter
+	uint32_t randBlock[4]; // current block of random bits
+	int randBlockIndex; // next unused pair in randBlock
+	
+	static const int RANDN_BUFFER = 64; // size of the buffer of normal variables
+	double aRand[RANDN_BUFFER]; // buffer of normal variables
+	int nRand; // index into aRand
+	
+	/// Restart the stream with the current seed and run number.
+	void rekey();
 	
-	static int nRand; // index into aRand
-	static double aRand[2]; // two random variables
+	/// Restart the stream if seed or run number of the time object changed.
+	void checkEpoch() {
+		if (randTime && randEpoch != randTime->getRandomEpoch())
+			rekey();
+	};
 	
 public:
 	
 	/// Construct.
+	/** Creates a stream with the default seed, for objects without a time object. */
 	RandN();
 	
+	/// Construct.
+	/** Creates a stream which takes seed and run number from the time object. */
+	RandN( class Time *time );
+	
 	/// Destruct.
 	~RandN();
 	
+	/// Set the stream number.
+	/** The stream number is assigned at construction. Setting it explicitly makes the numbers independent of the order of construction. The stream is restarted. */
+	void setStream( uint stream );
+	
+	/// Get the stream number.
+	uint getStream() const { return randStream; };
+	
+	/// Default seed.
+	/** Seed used by time objects which were not given a seed. It is read from /dev/urandom once. */
+	static uint64_t getDefaultSeed();
+	
 	/// Retrieve random variable.
-	/** This function generates one random variable. The returend values are normally (Gaussian) distributed, with a mean of 0.0 and a variance of 1.0. The method used is the Polar-Masaglia method, which is the quickest known so far. */
-	double dRandN();
+	/** This function generates one random variable. The returend values are normally (Gaussian) distributed, with a mean of 0.0 and a variance of 1.0. The values are taken from a buffer, which is refilled with fillN(). */
+	double dRandN() {
+		if (nRand == RANDN_BUFFER || (randTime && randEpoch != randTime->getRandomEpoch())) {
+			fillN(aRand, RANDN_BUFFER);
+			nRand = 0;
+		}
+		return aRand[nRand++];
+	};
 	
 	/// Retrieve random variable.
 	/** This function generates one random variable. The returend values are evenly distributed between 0 and 1. */
 	double dRandE();
+	
+	/// Retrieve Poisson distributed random variable.
+	/** Returns the number of events of a Poisson process with the given expected number. Small means are drawn by inversion, which costs about mean+1 uniform variables, larger means by Hörmann's transformed rejection (PTRS), which costs about two, so the cost is bounded for any mean. */
+	uint nRandP(
+		double mean   ///< expected value
+	);
+	
+	/// Retrieve many random variables.
+	/** Writes n normally (Gaussian) distributed values with a mean of 0.0 and a variance of 1.0. The Box-Muller method is used on whole blocks, in loops without branches, which the compiler vectorises. Much quicker than calling dRandN() n times when n is large. */
+	void fillN(
+		double *values,   ///< array for at least n values
+		uint n   ///< number of values
+	);
+	
+	/// Retrieve many random variables.
+	/** Writes n values evenly distributed between 0 and 1. */
+	void fillE(
+		double *values,   ///< array for at least n values
+		uint n   ///< number of values
+	);
 };
 
 #endif
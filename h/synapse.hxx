@@ -52,6 +52,10 @@ public:
 		const string& type="Synapse"   ///< object type
 	);
 	
+	/// Objects this synapse reads.
+	/** The dependencies and the pre-synaptic neuron. */
+	virtual void getInputs( vector<TimeDependent *> &inputs ) { getDependencies(inputs); if (simplePreNeuron) inputs.push_back(simplePreNeuron); };
+	
 	/// Return current value.
 	virtual double calculateCurrentValue();
 	
@@ -79,6 +83,8 @@ public:
 /** This class implements a  synapse which is characterized by a differential equation. Main feature is the transformation of digital signals from an Event object (usually a neuron) to analog values of a StochasticProcess object, which then are part of the membrane equation of another neuron. It also possible to use a noise source (such as a Wiener process) as input. This depends on the constructor you use. Since a synapse usually connects from one single neuron to another single neuron, this class is set to be active as default, i.e. is forwarded automatically and you don't have to use proceedToNextState() and prepareNextState() inside your program. */
 class SimpleSynapse: public Synapse
 {
+	friend class AggregateConductance;
+	
 private:
 	double simplePeakCnd;
 	double simpleTimeConstant;
@@ -92,9 +98,13 @@ protected:
 	/** only used when the noise constructor was used */
 	StochasticVariable *stochastic;
 	
+	/// Time process of the rate equation.
+	/** Only used when the event constructor was used. The synapse then steps the rate equation itself, it is not attached to the time object. The time process stays attached, as the rate equation integrates its increments, which round differently as time goes on. */
+	StochasticVariable *simpleClock;
+	
 public:	
 	/// Construct.
-	/** Will construct a synapse, which will set its value to the peak conductance just after the pre-synaptic spike, and decay the value according to the given time constant. At the next pre-synaptic spike the value will be set to the peak conductance again. */
+	/** Will construct a synapse, which will set its value to the peak conductance just after the pre-synaptic spike, and decay the value according to the given time constant. At the next pre-synaptic spike the value will be set to the peak conductance again. Once the conductance has decayed to exactly zero, the synapse sleeps until the next pre-synaptic spike (see TimeDependent::isDormant()). */
 	SimpleSynapse (
 		Time *time,   ///< pointer to main time object
 		StochasticEventGenerator *e,   ///<The object providing the events (spikes), i.e. the pre-synaptic neuron.
@@ -118,12 +128,27 @@ public:
 		return &differential;
 	}
 	
+	/// Objects this synapse depends on.
+	/** This is the rate equation, or its time process if the synapse steps the rate equation itself. The pre-synaptic neuron is no dependency, only its current state is used. */
+	virtual void getDependencies( vector<TimeDependent *> &dependencies ) { if (simpleClock) dependencies.push_back(simpleClock); else dependencies.push_back(&differential); };
+	
 	/// Calculate next state.
 	virtual void prepareNextState();
 	
 	/// Apply nex time step.
 	virtual void proceedToNextState();
 	
+	/// Reset the rate equation.
+	virtual void init();
+	
+	/// Whether the synapse may sleep.
+	/** True if the conductance is zero and no pre-synaptic spike is present. */
+	virtual bool isDormant();
+	
+	/// Objects which wake this synapse.
+	/** The spikes of the pre-synaptic neuron. */
+	virtual void getWakers( vector<TimeDependent *> &changes, vector<StochasticEventGenerator *> &events ) { if (simplePreNeuron) events.push_back(simplePreNeuron); };
+	
 	/// Calculate next value.
 	virtual double calculateNextValue();
 	
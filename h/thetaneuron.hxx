@@ -75,6 +75,8 @@ where
 
 class ThetaNeuron: public SpikingNeuron
 {
+	friend class PopulationDensity;
+	
 private:
 	DifferentialEquation thetaMembrane;	
 
@@ -88,6 +90,10 @@ public:
 	/// Add stimulus.
 	void addStimulus(StochasticVariable *integrator);
 	
+	/// Objects this neuron depends on.
+	/** This is the membrane equation. */
+	virtual void getDependencies( vector<TimeDependent *> &dependencies ) { dependencies.push_back(&thetaMembrane); };
+	
 	/// Next step
 	virtual void prepareNextState();
 };
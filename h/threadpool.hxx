@@ -0,0 +1,88 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#ifndef THREADPOOL_HXX
+#define THREADPOOL_HXX
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <sys/types.h>
+
+using std::vector;
+
+/// A task for the thread pool.
+/** Derive from this class and implement execute(). The pool calls execute() once on every worker, the worker index tells which share of the work to do. */
+class ThreadTask
+{
+public:
+	virtual ~ThreadTask() {};
+	
+	/// Do the share of one worker.
+	virtual void execute(
+		uint worker   ///< index of the worker, 0 is the calling thread
+	) = 0;
+};
+
+/// A persistent pool of worker threads.
+/** The threads are started once and wait for tasks. A call to run() wakes all of them, lets the calling thread work as worker 0, and returns when all workers have finished, so that each call is a barrier. This keeps the cost of a parallel phase down to a wake-up and a wait, which matters when a phase is a single time step. */
+class ThreadPool
+{
+private:
+	vector<std::thread> poolThreads;
+	std::mutex poolMutex;
+	std::condition_variable poolStart; // signalled when a new task is there
+	std::condition_variable poolDone; // signalled when the last worker is finished
+	ThreadTask *poolTask; // the current task
+	unsigned long long poolGeneration; // increased with every task
+	uint poolWaiting; // workers which haven't finished the current task
+	bool poolStop; // whether the threads should leave
+	
+	/// Loop of each worker thread.
+	void work( uint worker );
+	
+	// private copy constructor to prevent copying
+	ThreadPool( const ThreadPool & );
+	
+public:
+	/// Construct.
+	/** Starts threads-1 threads, the calling thread is the first worker. */
+	ThreadPool(
+		uint threads   ///< number of workers, including the calling thread
+	);
+	
+	/// Destruct.
+	/** Stops and joins all threads. */
+	~ThreadPool();
+	
+	/// Number of workers.
+	/** This includes the calling thread. */
+	uint size() { return poolThreads.size() + 1; };
+	
+	/// Execute a task on all workers.
+	/** Returns when all workers have finished. */
+	void run( ThreadTask *task );
+};
+
+#endif
@@ -38,6 +38,7 @@ private:
 	StochasticVariable *detectorSource;
 	double detectorThreshold;
 	bool detectorBelow;
+	RandN *detectorBridge; // random numbers for crossing detection, 0 without correction
 	
 public:
 	/// Construction
@@ -48,13 +49,57 @@ public:
 		detectorSource = source;
 		detectorThreshold = threshold;
 		detectorBelow = below;
+		detectorBridge = 0;
+		eventCurrentValue = eventNextValue = false;
 	};
 	
 	/// Destruction
-	virtual ~ThresholdDetector() {}
+	virtual ~ThresholdDetector() {
+		if (detectorBridge)
+			delete detectorBridge;
+	}
+	
+	/// Detect threshold crossings between time steps.
+	/** Without correction there is an event whenever the source is beyond the threshold at a time step. With correction there is also an event if the source crossed the threshold and came back between two time steps. This is decided randomly with the exit probability of a Brownian bridge, using the quadratic variation of the source (see IfNeuron::setCrossingCorrection()). The time of the crossing is interpolated and reported through getEventOffset(). */
+	void setCrossingCorrection( bool correction ) {
+		if (correction && !detectorBridge)
+			detectorBridge = new RandN(xTime);
+		else if (!correction && detectorBridge) {
+			delete detectorBridge;
+			detectorBridge = 0;
+		}
+	};
+	
+	/// Objects this detector depends on.
+	/** This is the source. */
+	virtual void getDependencies( vector<TimeDependent *> &dependencies ) { dependencies.push_back(detectorSource); };
+	
+	/// Calculate next value.
+	/** Only needed with crossing correction, which looks at the whole step of the source. */
+	virtual void prepareNextState() {
+		stochNextStateIsPrepared = true;
+		if (!detectorBridge)
+			return;
+		
+		// distances beyond the threshold, positive if there is an event
+		double sign = detectorBelow ? -1.0 : 1.0;
+		double current = sign * (detectorSource->getCurrentValue() - detectorThreshold);
+		double next = sign * (detectorSource->getNextValue() - detectorThreshold);
+		eventNextValue = next > 0.0;
+		eventNextOffset = (eventNextValue && current < 0.0) ? next / (next - current) : 0.0;
+		if (!eventNextValue) {
+			double variance = detectorSource->getQuadraticVariation();
+			if (variance > 0.0 && detectorBridge->dRandE() < exp(-2.0 * current * next / variance)) {
+				eventNextValue = true;
+				eventNextOffset = next / (current + next);
+			}
+		}
+	};
 	
 	/// has event?
 	bool hasEvent() {
+		if (detectorBridge)
+			return eventCurrentValue;
 		if (detectorBelow)
 			return (detectorSource->getCurrentValue() < detectorThreshold);
 		else
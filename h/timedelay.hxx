@@ -36,6 +36,16 @@ class TimeDelay : public T
 	private:
 		T *delaySource;
 		Ring<double> delayData;
+		double delayLast; // last sample
+		uint delayQuiet; // number of equal samples in a row, the ring starts with zeros
+		
+		// store a sample
+		void sample( double d )
+		{
+			delayQuiet = (d == delayLast) ? delayQuiet + 1 : 1;
+			delayLast = d;
+			delayData.next(d);
+		}
 		
 	public:
 		
@@ -45,6 +55,8 @@ class TimeDelay : public T
 		delayData(samplesDelay+1)
 		{
 			delaySource = source;
+			delayLast = 0.0;
+			delayQuiet = samplesDelay + 1;
 		}
 		
 		/// for base classes like construct( double, time* )
@@ -53,6 +65,15 @@ class TimeDelay : public T
 		delayData(samplesDelay+1)
 		{
 			delaySource = source;
+			delayLast = 0.0;
+			delayQuiet = samplesDelay + 1;
+		}
+		
+		/// Objects this delay depends on.
+		/** This is the delayed source. */
+		virtual void getDependencies( vector<TimeDependent *> &dependencies )
+		{
+			dependencies.push_back( delaySource );
 		}
 		
 		// prepare next state for classes deriving from stoch
@@ -60,19 +81,26 @@ class TimeDelay : public T
 		{
 			if (delaySource->isNextStatePrepared() ) {
                 if (std::is_base_of<StochasticEventGenerator, T>::value) {
-                    delayData.next( delaySource->hasEvent() );
+                    sample( delaySource->hasEvent() );
                     T::stochNextValue = delayData[1];
                     T::eventNextValue = bool(T::stochNextValue);
                     T::stochNextStateIsPrepared = true;
                 }
                 else if (std::is_base_of<StochasticProcess, T>::value) {
-                    delayData.next( delaySource->getCurrentValue() );
+                    sample( delaySource->getCurrentValue() );
                     T::stochNextValue = delayData[1];
                     T::stochNextStateIsPrepared = true;
                 }
 			}
 		}
 		
+		/// Whether the delay may sleep.
+		/** True once the whole delay and the current value hold the same sample, the value then stays until the source changes. */
+		virtual bool isDormant()
+		{
+			return delayQuiet > (uint)delayData.length();
+		}
+		
 };
 
 #endif
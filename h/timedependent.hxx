@@ -29,11 +29,14 @@ __________________________________________________________________________
 #include "estimator.hxx"
 
 #include <vector>
+#include <map>
 #include <sys/types.h>
 
 using std::vector;
+using std::map;
 
 class StochasticEventGenerator;
+class ThreadPool;
 
 /// Class used for piping output into nothingness
 class NullStream : public std::ostream
@@ -52,6 +55,31 @@ class DataCollector
 		
 		/// Will be executed after each run.
 		virtual void afterRun(const vector<unsigned long long int>& step) = 0;
+		
+		/// Will be executed before each run of a replica.
+		/** Used by parallel nested runs, the replica is the time object of the network which performs the run. Calls are never concurrent. The default calls beforeRun(). */
+		virtual void beforeReplicaRun(const vector<unsigned long long int>& step, class Time *replica) { beforeRun(step); };
+		
+		/// Will be executed after each run of a replica.
+		/** Used by parallel nested runs, called after the estimators of the replica were merged. Calls are never concurrent. The default calls afterRun(). */
+		virtual void afterReplicaRun(const vector<unsigned long long int>& step, class Time *replica) { afterRun(step); };
+};
+
+/// Class used to build copies of a network for parallel nested runs
+/** Each replica is a complete network with its own Time object. The estimators of a replica must be created in the same order as those attached to the time object which runs the replicas, so that they can be merged one by one. */
+class ReplicaFactory
+{
+	public:
+		
+		/// Create a replica.
+		/** Builds a complete network on a new Time object, and returns the time object. */
+		virtual class Time *createReplica(
+			uint replica   ///< index of the replica, one per worker
+		) = 0;
+		
+		/// Destroy a replica.
+		/** Frees a network built by createReplica(). */
+		virtual void destroyReplica( class Time *replica ) = 0;
 };
 
 /// Time dependent objects.
@@ -85,6 +113,30 @@ public:
 	/// Whether the next state is prepared or not.
 	virtual bool isNextStatePrepared() = 0;
 	
+	/// Objects this object depends on.
+	/*! Appends all objects whose next state must be prepared before prepareNextState() of this object can succeed. Time uses this to order its objects, so that one call to prepareNextState() per step suffices. Objects of which only the current state is read (like the pre-synaptic neuron of a Synapse) are no dependencies. The default has no dependencies. */
+	virtual void getDependencies( vector<TimeDependent *> &dependencies ) {};
+	
+	/// Objects this object reads.
+	/*! Appends all objects whose values this object uses, including those of which only the current state is read. Time::getSubgraph() follows these to find everything an object needs to run on its own. The default are the dependencies. */
+	virtual void getInputs( vector<TimeDependent *> &inputs ) { getDependencies(inputs); };
+	
+	/// Whether the object may sleep.
+	/*! Opt-in for objects which are idle most of the time. Time asks this after each step in which the object was prepared. Return true if the next state equals the current state, and keeps doing so until one of the objects given by getWakers() changes or fires. Time then neither prepares nor proceeds the object until it wakes it. While the object sleeps, isNextStatePrepared() stays true, so objects depending on it go on, and a call to proceedToNextState() must not change anything but that flag. Sleeping objects are only skipped when stepping with one thread. The default never sleeps. */
+	virtual bool isDormant() { return false; };
+	
+	/// Objects which wake this object.
+	/*! Appends the objects whose changes end the sleep of this object (see isChanging()) to changes, and the event generators whose events end it to events. Objects not attached to the same time object never wake it. The default wakes on any change of the inputs. */
+	virtual void getWakers( vector<TimeDependent *> &changes, vector<StochasticEventGenerator *> &events ) { getInputs(changes); };
+	
+	/// Whether the step being taken changes this object.
+	/*! Asked after the object was prepared, if another object sleeps until it changes. The default always reports a change. */
+	virtual bool isChanging() { return true; };
+	
+	/// Whether the object reads the time passed.
+	/*! Return true if the object uses Time::timePassed of its time object, f.i. to play events or to follow a rate profile. Such an object can only be stepped by its own time object, so Calibration runs the neurons reading it on the network. The default is false. */
+	virtual bool readsTimePassed() { return false; };
+	
 	/// Return pointer to the time object
 	virtual class Time *getTime() const { return xTime; };
 };
@@ -97,9 +149,87 @@ class Time: public Physical
 private:
 	vector<class TimeDependent *> timeObjects;
 	vector<class Estimator *> timeEstimators;
+	vector<class TimeDependent *> timeSchedule; // timeObjects in dependency order
+	bool timeScheduleValid; // whether timeSchedule reflects the current dependency graph
+	
+	class ThreadPool *timePool; // workers for parallel steps, 0 if never used
+	uint timeThreads; // number of threads used for stepping
+	bool timeParallel; // whether the objects are spread over more than one worker
+	vector< vector<class TimeDependent *> > timePrepareLists; // objects of each worker, in dependency order
+	vector< vector<class TimeDependent *> > timeProceedLists; // objects of each worker, in proceeding order
+	vector<char> timeWorkerSuccess; // whether each worker could prepare all its objects
+	
+	// sleeping objects, see TimeDependent::isDormant(), all indexed by the position in timeSchedule
+	map<class TimeDependent *, uint> timePositions; // position of each object
+	vector<uint> timeOrder; // index of each object in timeObjects
+	vector<uint> timeActive; // objects awake, in dependency order
+	vector<uint> timeActiveProceeding; // objects awake, in proceeding order
+	vector<uint> timeWoken; // objects woken since the active lists were built
+	vector<uint> timeWaking; // heap of objects woken ahead of the one being prepared
+	bool timeActiveValid; // whether the active lists reflect all sleeping and woken objects
+	vector<char> timeAsleep; // whether each object sleeps
+	vector<char> timeWatched; // whether the wakers of each object are known
+	vector<unsigned long long> timeAwakeUntil; // last step in which each object must not fall asleep
+	vector< vector<uint> > timeChangeSleepers; // objects woken by a change of each object
+	vector< vector<uint> > timeEventSleepers; // objects woken by an event of each object
+	vector<class StochasticEventGenerator *> timeEventSources; // each object as an event generator, if it wakes others by events
+	unsigned long long timeStep; // number of steps taken
+	
+	unsigned long long timeSeed; // seed of all random streams, 0 for the default seed
+	unsigned long long timeRun; // number of the next run
+	unsigned long long timeRandomRun; // number of the run the random streams are keyed with
+	unsigned long long timeRandomEpoch; // increased whenever the random streams restart
+	uint timeStreams; // number of random streams handed out
+	friend class TimePhase;
+	friend class ReplicaTask;
 	
 	/// Proceed time be one step.
 	bool step();
+	
+	/// Advance all objects to their next state.
+	void proceed();
+	
+	/// Prepare a list of objects.
+	/** Calls prepareNextState() once for each object in the given order, then resolves what is left. */
+	bool prepare( vector<class TimeDependent *> &objects );
+	
+	/// Set the number of threads used for stepping.
+	/** Starts the thread pool if necessary. */
+	void setThreads( uint threads );
+	
+	/// Sort all objects by their dependencies.
+	/** Builds the dependency graph from TimeDependent::getDependencies() and orders it topologically. Objects without mutual dependencies keep the order in which the former fixed-point loop visited them (last registered first). Objects in circular dependencies are appended at the end. */
+	void buildSchedule();
+	
+	/// Split the objects among the workers.
+	/** Objects connected by dependencies form a group that is always stepped by one worker. Groups are distributed so that each worker has about the same number of objects. */
+	void buildPartitions();
+	
+	/// Prepare the objects awake.
+	/** Like prepare(), but skips sleeping objects, wakes the objects sleeping on a change of a prepared one, and lets objects fall asleep. */
+	bool prepareActive();
+	
+	/// Proceed the objects awake.
+	/** Wakes the objects sleeping on an event of a proceeded one. */
+	void proceedActive();
+	
+	/// Check a prepared object.
+	/** Wakes the objects sleeping on a change of the object at the given position, and lets the object fall asleep if it wishes. */
+	void settle( uint position, bool ahead );
+	
+	/// Mark an object as awake.
+	/** \return whether it was asleep */
+	bool wakeUp( uint position );
+	
+	/// Wake all sleeping objects.
+	void wakeAll();
+	
+	/// Rebuild the active lists.
+	void buildActive();
+	
+	/// Prepare objects which are still waiting.
+	/** Fixed-point loop for objects with undeclared or circular dependencies. Repeatedly sweeps the objects until all are prepared or none changes any more. */
+	bool resolve( vector<class TimeDependent *> &objects );
 
 public:
 	double dt;
@@ -108,12 +238,23 @@ public:
 	/// Create time.
 	Time(double timestep) {
 		dt = timestep; 
+		timeScheduleValid = false;
+		timePool = 0;
+		timeThreads = 1;
+		timeParallel = false;
+		timeSeed = 0;
+		timeRun = 0;
+		timeRandomRun = 0;
+		timeRandomEpoch = 0;
+		timeStreams = 0;
+		timeActiveValid = false;
+		timeStep = 0;
 		physicalUnit.set(0, 0,0,1,0,0,0,0); // ms
 		physicalDescription = "time";
 	};
 	
 	/// Destroy time.
-	virtual ~Time(){};
+	virtual ~Time();
 	
 	/// Return physick description.
 	virtual string getPhysicalDescription() {
@@ -126,15 +267,17 @@ public:
 		double startTime,     ///< time value to start witch
 		double endTime,     ///< time value to stop at
 		 ostream &log = cout,   ///< stream for progress messages
-		 bool init = true ///< include initialising of all dependent objects
+		 bool init = true, ///< include initialising of all dependent objects
+		 uint threads = 1 ///< number of threads to step independent objects in parallel
 	);
 
 	/// Run simulation for all attached objects.
-	/** Runs a simulation for a certain number of time steps. This function does not reset the Time::timePassed value before start. */
+	/** Runs a simulation for a certain number of time steps. This function does not reset the Time::timePassed value before start. If more than one thread is given, groups of objects without dependencies between them are stepped in parallel. The result is the same as with one thread, as long as the objects do not share random number streams. */
 	void run (
 		  unsigned long long steps,   ///< number of time steps to run
 		 ostream &log = cout,   ///< stream for progress messages
-		 bool init = true ///< include initialising of all dependent objects
+		 bool init = true, ///< include initialising of all dependent objects
+		 uint threads = 1 ///< number of threads to step independent objects in parallel
 	);
 
 	/// Run simulation for all attached objects.
@@ -144,7 +287,8 @@ public:
 		class StochasticEventGenerator *eventSource,   ///< event source
 		unsigned long long maxSteps,   ///< maximum number of time steps, should the event source fail
 		ostream &log = cout,   ///< stream for progress messages
-		bool init = true ///< include initialising of all dependent objects
+		bool init = true, ///< include initialising of all dependent objects
+		uint threads = 1 ///< number of threads to step independent objects in parallel
 	);
 	
 	/// Run multiple simulations for all attached objects.
@@ -153,7 +297,8 @@ public:
 		unsigned long long steps,   ///< number of time stepsfor each run
 		unsigned long long runs,   ///< number of time runs
 		DataCollector *runRecorder,   ///< object with functions to execute at beginning/end of each run
-		ostream &log = cout   ///< stream for progress messages
+		ostream &log = cout,   ///< stream for progress messages
+		uint threads = 1 ///< number of threads to step independent objects in parallel
 	);
 	
 	/// Run multiple simulations for all attached objects.
@@ -164,7 +309,30 @@ public:
 		unsigned long long maxSteps,   ///< maximum number of time steps, should the event source fail
 		unsigned long long runs,   ///< number of time runs
 		DataCollector *runRecorder,   ///< object with functions to execute at beginning/end of each run
-		ostream &log = cout   ///< stream for progress messages
+		ostream &log = cout,   ///< stream for progress messages
+		uint threads = 1 ///< number of threads to step independent objects in parallel
+	);
+	
+	/// Run multiple simulations in parallel.
+	/** Runs a number of simulations for a certain number of time steps, each on a replica of the network. One replica is built by the factory for each thread, the threads take the next run whenever they are done with one. After each run the estimators of the replica are merged into the estimators attached to this object, which then hold the result of all runs. */
+	void runNested (
+		unsigned long long steps,   ///< number of time steps for each run
+		unsigned long long runs,   ///< number of time runs
+		ReplicaFactory *factory,   ///< builds one network per thread
+		DataCollector *runRecorder,   ///< object with functions to execute at beginning/end of each run
+		ostream &log = cout,   ///< stream for progress messages
+		uint threads = 1 ///< number of replicas running in parallel
+	);
+	
+	/// Merge estimators of a replica.
+	/** Adds the results of all estimators of the given replica to the estimators of this object, one by one in the order they were attached. */
+	void merge( Time *replica );
+	
+	/// Find all objects an object reads.
+	/** Follows TimeDependent::getInputs() from the given objects and appends all objects attached to this time object which are reached, including the objects themselves. They are appended in the order they were attached, so a Time object holding only these steps them in the same order. */
+	void getSubgraph(
+		const vector<class TimeDependent *> &objects,   ///< objects to start from
+		vector<class TimeDependent *> &subgraph   ///< objects found
 	);
 	
 	/// Attach an object.
@@ -178,6 +346,39 @@ public:
 	
 	/// Detach an object.
 	void remove( class Estimator *object );
+	
+	/// Wake a sleeping object.
+	/** For objects changed from outside the simulation, f.i. when a parameter is set between runs. Initialising the objects at the start of a run wakes all of them. */
+	void wake( class TimeDependent *object );
+	
+	/// Set the seed.
+	/** All random streams of objects attached to this time object are derived from this seed, the run number and the number of the stream. Restarts all streams. Without a seed, a default seed read from /dev/urandom is used. */
+	void setSeed( unsigned long long seed ) { timeSeed = seed; ++timeRandomEpoch; };
+	
+	/// Get the seed.
+	unsigned long long getSeed();
+	
+	/// Set the number of the next run.
+	/** Each run which initialises the objects restarts all random streams with this number, and increases it by one. Setting it to the number of an earlier run (with the same seed) replays that run exactly. Nested runs use consecutive numbers from here. */
+	void setRun( unsigned long long run ) { timeRun = run; };
+	
+	/// Get the number of the next run.
+	unsigned long long getRun() const { return timeRun; };
+	
+	/// Run number the random streams are currently keyed with.
+	unsigned long long getRandomRun() const { return timeRandomRun; };
+	
+	/// Counter telling random streams to restart.
+	/** Increases whenever the seed or the run number of the streams change. */
+	unsigned long long getRandomEpoch() const { return timeRandomEpoch; };
+	
+	/// Hand out a stream number.
+	/** Called by each random stream at construction. */
+	uint newStream() { return timeStreams++; };
+	
+	/// Invalidate the dependency order.
+	/** Must be called when the dependencies of an attached object change (f.i. when a term is added to a DifferentialEquation). The order is rebuilt before the next step. */
+	void invalidateSchedule() { timeScheduleValid = false; };
 };
 
 #endif
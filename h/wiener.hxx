@@ -65,6 +65,7 @@ public:
 	virtual void setVariance(double);
 	virtual void setStdDev(double);
 	virtual double getDelta();
+	virtual double getQuadraticVariation();
 	virtual string getParameter(const string&) const;
 	virtual void setParameter(const string&, const string&);
 };
@@ -35,9 +35,11 @@ int main(int argc, char **argv)
 	nrnOne.addStimulus( &noiseOne, weight, revpot );
 	nrnTwo.addStimulus( &noiseTwo, weight, revpot );
 	
-	// calibrate both neurons to spike at 5Hz
-	nrnOne.calibrate(200, 40, 500);
-	nrnTwo.calibrate(200, 40, 500);
+	// calibrate both neurons to spike at 5Hz, at the same time on two threads
+	Calibration calibration(&time);
+	calibration.add(&nrnOne, 200);
+	calibration.add(&nrnTwo, 200);
+	calibration.run(40, 500, 2);
 	
 	// create two excitatory synapses from each neuron
 	revpot = -80.0, weight = 0.1;
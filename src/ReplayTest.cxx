@@ -0,0 +1,53 @@
+
+#include "../h/neurolab"
+
+// Checks that a run can be replayed exactly with Time::setRun(), whatever ran before, with
+// Ornstein-Uhlenbeck noises which keep a state of their own. Build with
+//   g++ -O2 -I h src/ReplayTest.cxx -o ReplayTest -lneurolab
+
+// records two coloured noises and a neuron driven by one of them, in every step of one run
+vector<double> record( Time &t, vector<StochasticProcess *> &processes, int steps )
+{
+	NullStream devnull;
+	vector<double> trace;
+	for (int s=0; s<steps; ++s) {
+		t.run(1ULL, devnull, s==0);
+		for (uint i=0; i<processes.size(); ++i)
+			trace.push_back(processes[i]->getCurrentValue());
+	}
+	return trace;
+}
+
+int main( int argc, char **argv )
+{
+	Time t(0.1);
+	t.setSeed(5);
+	NoiseSource source(&t, 2);
+	vector<StochasticProcess *> processes;
+	for (int i=0; i<2; ++i) {
+		Noise *noise = source.createNoise(i, "Correlated Ornstein-Uhlenbeck Process");
+		((OUNoise *) noise)->setTau(2.0 + i);
+		noise->setStdDev(1.0);
+		processes.push_back(noise);
+	}
+	IfNeuron neuron(&t, -60.0, -50.0, -20.0, 5.0, -70.0);
+	neuron.addStimulus(source[0]);
+	processes.push_back(&neuron);
+	
+	// run 3 first, then again after other runs
+	t.setRun(3);
+	vector<double> first = record(t, processes, 2000);
+	t.setRun(0);
+	record(t, processes, 1000);
+	record(t, processes, 500);
+	t.setRun(3);
+	vector<double> replay = record(t, processes, 2000);
+	
+	uint differences = 0;
+	for (uint i=0; i<first.size(); ++i)
+		if (first[i] != replay[i])
+			++differences;
+	cout << "compared " << first.size() << " values, " << differences << " differ" << endl;
+	cout << (differences ? "FAILED" : "passed") << endl;
+	return differences ? 1 : 0;
+}
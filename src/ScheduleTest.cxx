@@ -0,0 +1,58 @@
+
+#include "../h/neurolab"
+
+// Checks that the order in which Time prepares its objects follows their dependencies, and not
+// the order in which they were attached. Build with
+//   g++ -O2 -I h src/ScheduleTest.cxx -o ScheduleTest -lneurolab
+
+// runs a chain of filters, each driven by the increments of the one before, the first by noise,
+// and records all of them in every step
+vector<double> simulate( bool reversed, int length, int steps )
+{
+	NullStream devnull;
+	Time t(0.1);
+	t.setSeed(3);
+	
+	// the chain, attached from its end if reversed
+	vector<DifferentialEquation *> chain(length);
+	for (int i=0; i<length; ++i) {
+		int k = reversed ? length-1-i : i;
+		chain[k] = new DifferentialEquation(&t, 0.0, 0.0);
+	}
+	TimeProcess clock(&t);
+	Wiener noise(&t);
+	noise.setParameter("variance", "1.0");
+	
+	// dX_0 = -X_0 dt + dW, dX_k = -X_k dt + dX_{k-1}
+	Product decay(-1.0);
+	Scalar one(1.0, "one");
+	for (int k=0; k<length; ++k) {
+		chain[k]->addTerm(&decay, &clock);
+		chain[k]->addTerm(&one, k ? (StochasticVariable *) chain[k-1] : (StochasticVariable *) &noise);
+	}
+	
+	vector<double> trace;
+	for (int s=0; s<steps; ++s) {
+		t.run(1ULL, devnull, s==0);
+		for (int k=0; k<length; ++k)
+			trace.push_back(chain[k]->getCurrentValue());
+	}
+	
+	for (int k=0; k<length; ++k)
+		delete chain[k];
+	return trace;
+}
+
+int main( int argc, char **argv )
+{
+	vector<double> forward = simulate(false, 5, 10000);
+	vector<double> reversed = simulate(true, 5, 10000);
+	
+	uint differences = 0;
+	for (uint i=0; i<forward.size(); ++i)
+		if (forward[i] != reversed[i])
+			++differences;
+	cout << "compared " << forward.size() << " values, " << differences << " differ" << endl;
+	cout << (differences ? "FAILED" : "passed") << endl;
+	return differences ? 1 : 0;
+}
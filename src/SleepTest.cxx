@@ -0,0 +1,83 @@
+
+#include "../h/neurolab"
+
+// Checks that letting idle objects sleep (see TimeDependent::isDormant()) gives the same
+// result as stepping every object in every step. Build with
+//   g++ -O2 -I h src/SleepTest.cxx -o SleepTest -lneurolab
+
+// objects which never sleep, as reference
+class AwakeSynapse: public SimpleSynapse
+{
+public:
+	AwakeSynapse(Time *time, StochasticEventGenerator *pre, double weight, double revPot, double peak, double tau)
+		: SimpleSynapse(time, pre, weight, revPot, peak, tau) {};
+	virtual bool isDormant() { return false; };
+};
+
+class AwakeDelay: public TimeDelay<StochasticEventGenerator>
+{
+public:
+	AwakeDelay(StochasticEventGenerator *source, uint samples, Time *time)
+		: TimeDelay<StochasticEventGenerator>(source, samples, time) {};
+	virtual bool isDormant() { return false; };
+};
+
+class AwakeCovariation: public Covariation
+{
+public:
+	AwakeCovariation(StochasticProcess *x, StochasticProcess *y) : Covariation(x, y) {};
+	virtual bool isDormant() { return false; };
+};
+
+// runs a neuron with sparse synaptic input, a delayed spike train and their covariation,
+// and records all three in every step
+vector<double> simulate( bool sleep, int synapses, int steps )
+{
+	NullStream devnull;
+	Time t(0.1);
+	t.setSeed(7);
+	IfNeuron neuron(&t, -60.0, 1000.0, -20.0, 5.0, -70.0);
+	vector<Poisson *> inputs;
+	vector<SimpleSynapse *> synapse;
+	for (int i=0; i<synapses; ++i) {
+		inputs.push_back( new Poisson(0.0002, &t) );
+		if (sleep)
+			synapse.push_back( new SimpleSynapse(&t, inputs.back(), 0.5, 0.0, 1.0, 0.2) );
+		else
+			synapse.push_back( new AwakeSynapse(&t, inputs.back(), 0.5, 0.0, 1.0, 0.2) );
+		neuron.addStimulus(synapse.back());
+	}
+	Poisson spikes(0.001, &t);
+	TimeDelay<StochasticEventGenerator> *delay = sleep ? new TimeDelay<StochasticEventGenerator>(&spikes, 30u, &t) : new AwakeDelay(&spikes, 30u, &t);
+	Covariation *covariation = sleep ? new Covariation(&neuron, delay) : new AwakeCovariation(&neuron, delay);
+	
+	vector<double> trace;
+	for (int s=0; s<steps; ++s) {
+		t.run(1ULL, devnull, s==0);
+		trace.push_back(neuron.getCurrentValue());
+		trace.push_back(delay->getCurrentValue());
+		trace.push_back(covariation->getCurrentValue());
+	}
+	
+	delete covariation;
+	delete delay;
+	for (int i=0; i<synapses; ++i) {
+		delete synapse[i];
+		delete inputs[i];
+	}
+	return trace;
+}
+
+int main( int argc, char **argv )
+{
+	vector<double> awake = simulate(false, 500, 20000);
+	vector<double> asleep = simulate(true, 500, 20000);
+	
+	uint differences = 0;
+	for (uint i=0; i<awake.size(); ++i)
+		if (awake[i] != asleep[i])
+			++differences;
+	cout << "compared " << awake.size() << " values, " << differences << " differ" << endl;
+	cout << (differences ? "FAILED" : "passed") << endl;
+	return differences ? 1 : 0;
+}
@@ -0,0 +1,69 @@
+
+#include "../h/neurolab"
+
+// Checks that stepping independent groups of objects on several threads gives the same result
+// as stepping them on one. Build with
+//   g++ -O2 -I h src/ThreadTest.cxx -o ThreadTest -lneurolab
+
+// runs pairs of coupled neurons driven by noise and Poisson synapses, records all membranes in every step
+vector<double> simulate( uint threads, int pairs, int steps )
+{
+	NullStream devnull;
+	Time t(0.1);
+	t.setSeed(11);
+	vector<IfNeuron *> neurons;
+	vector<StochasticVariable *> inputs;
+	vector<SimpleSynapse *> synapses;
+	for (int i=0; i<2*pairs; ++i) {
+		neurons.push_back( new IfNeuron(&t, -60.0, -50.0, -20.0, 5.0, -70.0) );
+		Wiener *noise = new Wiener(&t);
+		noise->setParameter("mean", "1.5");
+		noise->setParameter("variance", "4.0");
+		neurons.back()->addStimulus(noise);
+		inputs.push_back(noise);
+		Poisson *spikes = new Poisson(0.05, &t);
+		synapses.push_back( new SimpleSynapse(&t, spikes, 0.2, 0.0, 1.0, 2.0) );
+		neurons.back()->addStimulus(synapses.back());
+		inputs.push_back(spikes);
+	}
+	
+	// couple the neurons of each pair
+	for (int p=0; p<pairs; ++p) {
+		synapses.push_back( new SimpleSynapse(&t, neurons[2*p], 0.5, 0.0, 1.0, 3.0) );
+		neurons[2*p+1]->addStimulus(synapses.back());
+		synapses.push_back( new SimpleSynapse(&t, neurons[2*p+1], 0.5, -80.0, 1.0, 3.0) );
+		neurons[2*p]->addStimulus(synapses.back());
+	}
+	
+	vector<double> trace;
+	for (int s=0; s<steps; ++s) {
+		t.run(1ULL, devnull, s==0, threads);
+		for (uint i=0; i<neurons.size(); ++i)
+			trace.push_back(neurons[i]->getCurrentValue());
+	}
+	
+	for (uint i=0; i<synapses.size(); ++i)
+		delete synapses[i];
+	for (uint i=0; i<neurons.size(); ++i)
+		delete neurons[i];
+	for (uint i=0; i<inputs.size(); ++i)
+		delete inputs[i];
+	return trace;
+}
+
+int main( int argc, char **argv )
+{
+	vector<double> single = simulate(1, 4, 10000);
+	uint failed = 0;
+	for (uint threads=2; threads<=4; threads*=2) {
+		vector<double> parallel = simulate(threads, 4, 10000);
+		uint differences = 0;
+		for (uint i=0; i<single.size(); ++i)
+			if (single[i] != parallel[i])
+				++differences;
+		cout << threads << " threads: compared " << single.size() << " values, " << differences << " differ" << endl;
+		failed += differences;
+	}
+	cout << (failed ? "FAILED" : "passed") << endl;
+	return failed ? 1 : 0;
+}
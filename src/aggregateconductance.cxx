@@ -0,0 +1,177 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#include "../h/aggregateconductance.hxx"
+#include "../h/synapse.hxx"
+
+
+//____________________________________________________________________________
+//
+//  construct
+//
+
+AggregateConductance::AggregateConductance(Time *time, const string& name, const string& type)
+	: StochasticFunction(time, name, type)
+{
+	physicalUnit = Unit("m","V") * Unit("m","S") * Unit("", "s");
+	stochDescription = "synapse";
+	init();
+}
+
+
+//____________________________________________________________________________
+//
+//  inputs
+//
+
+uint AggregateConductance::getClass(double tau, double revPot)
+{
+	for (uint c=0; c<aggregateTau.size(); ++c)
+		if (aggregateTau[c] == tau && aggregateReversal[c] == revPot)
+			return c;
+	aggregateTau.push_back(tau);
+	aggregateReversal.push_back(revPot);
+	aggregateDecay.push_back(0.0);
+	aggregateState.push_back(0.0);
+	aggregateStateNext.push_back(0.0);
+	aggregateJump.push_back(0.0);
+	updateDecay();
+	return aggregateTau.size() - 1;
+}
+
+void AggregateConductance::updateDecay()
+{
+	for (uint c=0; c<aggregateTau.size(); ++c)
+		aggregateDecay[c] = exp(-xTime->dt / aggregateTau[c]);
+}
+
+uint AggregateConductance::addInput(StochasticEventGenerator *pre, double weight, double revPot, double peak, double tau)
+{
+	aggregatePre.push_back(pre);
+	aggregateClass.push_back(getClass(tau, revPot));
+	aggregatePeak.push_back(weight * peak);
+	aggregateLastSpike.push_back(-1);
+	return aggregatePre.size() - 1;
+}
+
+int AggregateConductance::addSynapse(SimpleSynapse *synapse)
+{
+	if (!synapse->simplePreNeuron) {
+		cout << "AggregateConductance: synapse " << synapse->getName() << " is driven by a noise source and can't be aggregated" << endl;
+		return -1;
+	}
+	synapse->getTime()->remove(synapse);
+	synapse->getTime()->remove(&synapse->differential);
+	if (synapse->simpleClock)
+		synapse->getTime()->remove(synapse->simpleClock);
+	return addInput(synapse->simplePreNeuron, synapse->dWeight, synapse->dRevPot, synapse->simplePeakCnd, synapse->simpleTimeConstant);
+}
+
+
+//____________________________________________________________________________
+//
+//  value
+//
+
+double AggregateConductance::calculateCurrentValue()
+{
+	double value = 0.0;
+	for (uint c=0; c<aggregateState.size(); ++c)
+		value += (aggregateReversal[c] - stochCurrentValue) * (aggregateState[c] + aggregateJump[c]);
+	return value;
+}
+
+double AggregateConductance::calculateNextValue()
+{
+	double value = 0.0;
+	for (uint c=0; c<aggregateStateNext.size(); ++c)
+		value += (aggregateReversal[c] - stochNextValue) * aggregateStateNext[c];
+	return value;
+}
+
+double AggregateConductance::getDerivative(double x)
+{
+	double slope = 0.0;
+	for (uint c=0; c<aggregateState.size(); ++c)
+		slope -= aggregateState[c] + aggregateJump[c];
+	return slope;
+}
+
+bool AggregateConductance::getAffine(double &offset, double &slope)
+{
+	offset = slope = 0.0;
+	for (uint c=0; c<aggregateState.size(); ++c) {
+		double g = aggregateState[c] + aggregateJump[c];
+		offset += aggregateReversal[c] * g;
+		slope -= g;
+	}
+	return true;
+}
+
+
+//____________________________________________________________________________
+//
+//  step
+//
+
+void AggregateConductance::prepareNextState()
+{
+	if (stochNextStateIsPrepared)
+		return;
+	
+	for (uint c=0; c<aggregateState.size(); ++c)
+		aggregateStateNext[c] = aggregateState[c] * aggregateDecay[c];
+	
+	// as in SimpleSynapse a spike sets the input to its peak at once and for the next step, the sum jumps by the difference;
+	// the current state stays untouched, the jump is kept apart until proceeding
+	for (uint i=0; i<aggregatePre.size(); ++i)
+		if (aggregatePre[i]->hasEvent()) {
+			uint c = aggregateClass[i];
+			double before = 0.0;
+			if (aggregateLastSpike[i] >= 0)
+				before = aggregatePeak[i] * exp(-double(max(aggregateStep - aggregateLastSpike[i] - 1, 0L)) * xTime->dt / aggregateTau[c]);
+			aggregateJump[c] += aggregatePeak[i] - before;
+			aggregateStateNext[c] += aggregatePeak[i] - aggregateDecay[c] * before;
+			aggregateLastSpike[i] = aggregateStep;
+		}
+	stochNextStateIsPrepared = true;
+}
+
+void AggregateConductance::proceedToNextState()
+{
+	// the next state already holds the decayed jump
+	aggregateState.swap(aggregateStateNext);
+	aggregateJump.assign(aggregateJump.size(), 0.0);
+	++aggregateStep;
+	stochNextStateIsPrepared = false;
+}
+
+void AggregateConductance::init()
+{
+	aggregateState.assign(aggregateTau.size(), 0.0);
+	aggregateStateNext.assign(aggregateTau.size(), 0.0);
+	aggregateJump.assign(aggregateTau.size(), 0.0);
+	aggregateLastSpike.assign(aggregatePre.size(), -1);
+	aggregateStep = 0;
+	updateDecay();
+}
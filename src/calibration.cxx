@@ -0,0 +1,188 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#include "../h/calibration.hxx"
+#include "../h/threadpool.hxx"
+
+#include <map>
+#include <atomic>
+#include <mutex>
+
+//____________________________________________________________________________
+//
+//  groups of neurons, taken one by one by each worker
+//
+
+class CalibrationTask: public ThreadTask
+{
+public:
+	vector< vector<SpikingNeuron *> > &taskNeurons; // neurons of each group
+	vector< vector<int> > &taskIsi; // their target intervals
+	vector<Time *> &taskTimes; // time object of each group, 0 for groups run on the network
+	int taskSpikes;
+	int taskMaxtime;
+	ostream &taskLog;
+	std::atomic<uint> taskNextGroup;
+	uint taskFinished; // calibrated neurons
+	uint taskTotal; // all neurons
+	std::mutex taskMutex; // for the log
+	
+	CalibrationTask( vector< vector<SpikingNeuron *> > &neurons, vector< vector<int> > &isi, vector<Time *> &times, int spikes, int maxtime, uint total, ostream &log )
+		: taskNeurons(neurons), taskIsi(isi), taskTimes(times), taskLog(log), taskNextGroup(0) {
+		taskSpikes = spikes;
+		taskMaxtime = maxtime;
+		taskFinished = 0;
+		taskTotal = total;
+	};
+	
+	// calibrate the neurons of a group one after another
+	void calibrate( uint group, Time *time ) {
+		NullStream devnull;
+		for (uint i=0; i<taskNeurons[group].size(); ++i) {
+			taskNeurons[group][i]->calibrateThreshold(taskIsi[group][i], taskSpikes, taskMaxtime, 1.1, 0.8, time, devnull);
+			
+			std::lock_guard<std::mutex> lock(taskMutex);
+			++taskFinished;
+			taskLog << "\rcalibrated neuron " << taskFinished << " of " << taskTotal << "         \t" << flush;
+		}
+	};
+	
+	virtual void execute( uint worker ) {
+		for (;;) {
+			uint group = taskNextGroup++;
+			if (group >= taskNeurons.size())
+				break;
+			if (taskTimes[group])
+				calibrate(group, taskTimes[group]);
+		}
+	};
+};
+
+
+//____________________________________________________________________________
+//
+//  calibration
+//
+
+Calibration::Calibration( Time *time )
+{
+	calibrationTime = time;
+}
+
+void Calibration::add( SpikingNeuron *neuron, int isi )
+{
+	calibrationNeurons.push_back(neuron);
+	calibrationIsi.push_back(isi);
+}
+
+void Calibration::run( int spikes, int maxtime, uint threads, ostream &log )
+{
+	if (threads < 1)
+		threads = 1;
+	uint n = calibrationNeurons.size();
+	
+	// join neurons reading the same objects, with a union-find over the neurons
+	vector<uint> parent(n);
+	map<TimeDependent *, uint> reader; // first neuron reading each object
+	vector<TimeDependent *> start(1), subgraph;
+	for (uint i=0; i<n; ++i) {
+		parent[i] = i;
+		start[0] = calibrationNeurons[i];
+		subgraph.clear();
+		calibrationTime->getSubgraph(start, subgraph);
+		for (uint k=0; k<subgraph.size(); ++k) {
+			map<TimeDependent *, uint>::iterator found = reader.find(subgraph[k]);
+			if (found == reader.end())
+				reader[subgraph[k]] = i;
+			else {
+				uint a = found->second, b = i;
+				while (parent[a] != a) a = parent[a];
+				while (parent[b] != b) b = parent[b];
+				parent[b] = a;
+			}
+		}
+	}
+	
+	// collect the groups
+	map<uint, uint> groupOf; // group of each root
+	vector< vector<SpikingNeuron *> > neurons;
+	vector< vector<int> > isi;
+	for (uint i=0; i<n; ++i) {
+		uint root = i;
+		while (parent[root] != root) root = parent[root];
+		if (groupOf.find(root) == groupOf.end()) {
+			groupOf[root] = neurons.size();
+			neurons.push_back( vector<SpikingNeuron *>() );
+			isi.push_back( vector<int>() );
+		}
+		neurons[ groupOf[root] ].push_back(calibrationNeurons[i]);
+		isi[ groupOf[root] ].push_back(calibrationIsi[i]);
+	}
+	
+	// one time object for each group, holding only what the group reads;
+	// objects reading the time passed would see the network time stand still, so their groups stay on the network
+	vector<Time *> times;
+	uint onNetwork = 0;
+	for (uint g=0; g<neurons.size(); ++g) {
+		start.assign(neurons[g].begin(), neurons[g].end());
+		subgraph.clear();
+		calibrationTime->getSubgraph(start, subgraph);
+		bool readsTime = false;
+		for (uint k=0; k<subgraph.size(); ++k)
+			readsTime = readsTime || subgraph[k]->readsTimePassed();
+		if (readsTime) {
+			times.push_back(0);
+			++onNetwork;
+			continue;
+		}
+		times.push_back( new Time(calibrationTime->dt) );
+		times[g]->setSeed( calibrationTime->getSeed() );
+		for (uint k=0; k<subgraph.size(); ++k)
+			times[g]->add(subgraph[k]);
+	}
+	
+	// starting note
+	log << "\rstarting calibration: "
+			<< n << " neurons in "
+			<< neurons.size() << " groups on "
+			<< threads << " threads, "
+			<< onNetwork << " groups on the network.         \t"
+			<< endl;
+	
+	CalibrationTask task(neurons, isi, times, spikes, maxtime, n, log);
+	if (threads > 1) {
+		ThreadPool pool(threads);
+		pool.run(&task);
+	}
+	else
+		task.execute(0);
+	
+	// the network steps everything, so these go one by one after the others
+	for (uint g=0; g<times.size(); ++g)
+		if (!times[g])
+			task.calibrate(g, calibrationTime);
+	log << endl;
+	
+	for (uint g=0; g<times.size(); ++g)
+		delete times[g];
+}
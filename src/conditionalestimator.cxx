@@ -294,6 +294,38 @@ Matrix ConditionalEstimator::getEstimate(const Property& p)
 	return Matrix();
 }
 
+//________________________________________
+// add data of another estimator
+void ConditionalEstimator::merge(Estimator *other)
+{
+	ConditionalEstimator *e = dynamic_cast<ConditionalEstimator *>(other);
+	if( !e || e->nEstimate != nEstimate || e->nPre != nPre || e->nPost != nPost || e->nDist != nDist ) {
+		cout << "can't merge estimators with different properties" << endl;
+		return;
+	}
+	int size = nPre+nPost+1;
+	if( (nEstimate & EST_SAMPLE) && e->nSamples )
+		for(int i=0; i<size; i++)
+			condSamples[i] = e->condSamples[i];
+	if( nEstimate & EST_MEAN )
+		for(int i=0; i<size; i++)
+			aOne[i] += e->aOne[i];
+	if( nEstimate & EST_EVENTS )
+		for(int i=0; i<size; i++)
+			aEvents[i] += e->aEvents[i];
+	if( nEstimate & EST_VAR )
+		for(int i=0; i<size; i++)
+			aTwo[i] += e->aTwo[i];
+	if( nEstimate & EST_CUR )
+		for(int i=0; i<size; i++)
+			aThree[i] += e->aThree[i];
+	if( nEstimate & EST_DENS )
+		for(int i=0; i<size; i++)
+			for(int j=0; j<nDist; j++)
+				aDist[i][j] += e->aDist[i][j];
+	nSamples += e->nSamples;
+}
+
 //________________________________________
 // destruct
 ConditionalEstimator::~ConditionalEstimator()
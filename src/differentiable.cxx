@@ -22,6 +22,10 @@ __________________________________________________________________________
 */
 
 #include "../h/differentiable.hxx"
+#include "../h/processes.hxx"
+#include "../h/wiener.hxx"
+
+#include <cmath>
 
 
 //______________________________________________________________
@@ -40,8 +44,19 @@ DifferentialEquation::DifferentialEquation(double x0, double dx0, const string&
 	eqnMethodPtr = &DifferentialEquation::stepEulerIto;
 	stochCurrentValue = stochNextValue = x0;
 	eqnIncrement = dx0;
+	eqnTermKindsValid = false;
+	eqnIterations = 2;
+	eqnTolerance = 0.0;
+	eqnDepth = 6;
+	eqnSubsteps = 1;
+	eqnBridge = 0;
+	eqnExpRate = 0.0;
+	eqnExpDecay = eqnExpDrift = eqnExpNoise = 1.0;
 	addParameter("equation");
 	addParameter("mode");
+	addParameter("iterations");
+	addParameter("tolerance");
+	addParameter("depth");
 	addParameter("starting-value");
 }
 
@@ -56,13 +71,26 @@ DifferentialEquation::DifferentialEquation(Time *time, double x0, double dx0, co
 	eqnMethodPtr = &DifferentialEquation::stepEulerIto;
 	stochCurrentValue = stochNextValue = x0;
 	eqnIncrement = dx0;
+	eqnTermKindsValid = false;
+	eqnIterations = 2;
+	eqnTolerance = 0.0;
+	eqnDepth = 6;
+	eqnSubsteps = 1;
+	eqnBridge = 0;
+	eqnExpRate = 0.0;
+	eqnExpDecay = eqnExpDrift = eqnExpNoise = 1.0;
 	addParameter("equation");
 	addParameter("mode");
+	addParameter("iterations");
+	addParameter("tolerance");
+	addParameter("depth");
 	addParameter("starting-value");
 }
 
 DifferentialEquation::~DifferentialEquation()
 {
+	if (eqnBridge)
+		delete eqnBridge;
 }
 
 //____________________________________________________________________________
@@ -80,6 +108,8 @@ int DifferentialEquation::addTerm(StochasticFunction *integrand, StochasticVaria
 	else
 		integrand->getUnit() * integrator->getUnit();
 	eqnTermAmount = eqnIntegrands.size();
+	eqnTermKindsValid = false;
+	xTime->invalidateSchedule();
 	
 	// add parameter for new integrand
 	stringstream param1;
@@ -112,6 +142,8 @@ void DifferentialEquation::rmTerm(int n)
 		rmParameter( param2.str() );
 			
 		eqnTermAmount = eqnIntegrands.size();
+		eqnTermKindsValid = false;
+		xTime->invalidateSchedule();
 	}
 }
 
@@ -127,6 +159,8 @@ void DifferentialEquation::setTerm(int n, StochasticFunction *integrand, Stochas
 		eqnIntegrators[n] = integrator;
 	}
 	physicalUnit += integrand->getUnit() * integrator->getUnit();
+	eqnTermKindsValid = false;
+	xTime->invalidateSchedule();
 }
 
 // get integrand
@@ -152,6 +186,16 @@ StochasticVariable *DifferentialEquation::getIntegrator(int n)
 }
 
 
+// get dependencies
+void DifferentialEquation::getDependencies( vector<TimeDependent *> &dependencies )
+{
+	for (int i=0; i<eqnTermAmount; ++i) {
+		dependencies.push_back( eqnIntegrators[i] );
+		dependencies.push_back( eqnIntegrands[i] );
+	}
+}
+
+
 //______________________________________________________________
 //
 //  set current value
@@ -232,7 +276,7 @@ void DifferentialEquation::stepEulerStratonovich()
 	}
 	stochNextValue = stochCurrentValue + eqnIncrement; // start for 1-step fixed point iteration
 	
-	for( int n=0; n<2; n++ ) {	
+	for( int n=0; n<eqnIterations; n++ ) {	
 		double drift = 0.0;
 		for(int i=0; i<eqnTermAmount; i++) {
 			integrand = eqnIntegrands[i]->getIncrement( stochNextValue );
@@ -247,6 +291,231 @@ void DifferentialEquation::stepEulerStratonovich()
 	// cout << "DifferentialEquation::stochNextValue = " << stochNextValue << endl;
 }
 
+double DifferentialEquation::stepEulerTerms(double x)
+{
+	double increment = 0.0;
+	eqnDiffusive.clear();
+	eqnDiffusiveValues.clear();
+	eqnDiffusiveQV.clear();
+	for (int i=0; i<eqnTermAmount; ++i) {
+		double integrand = (*eqnIntegrands[i])(x);
+		increment += integrand * eqnIntegrators[i]->d();
+		double qv = eqnIntegrators[i]->getQuadraticVariation();
+		if (qv > 0.0) {
+			eqnDiffusive.push_back(i);
+			eqnDiffusiveValues.push_back(integrand);
+			eqnDiffusiveQV.push_back(qv);
+		}
+	}
+	return increment;
+}
+
+void DifferentialEquation::stepMilstein()
+{
+	double x = stochCurrentValue;
+	eqnIncrement = stepEulerTerms(x);
+	
+	// sum_jk f_k' f_j dY_j dY_k factorises, the diagonal holds the quadratic variation
+	double derivatives = 0.0, values = 0.0, diagonal = 0.0;
+	for (uint n=0; n<eqnDiffusive.size(); ++n) {
+		int i = eqnDiffusive[n];
+		double integrator = eqnIntegrators[i]->d();
+		double derivative = eqnIntegrands[i]->getDerivative(x);
+		derivatives += derivative * integrator;
+		values += eqnDiffusiveValues[n] * integrator;
+		diagonal += derivative * eqnDiffusiveValues[n] * eqnDiffusiveQV[n];
+	}
+	eqnIncrement += 0.5 * (derivatives * values - diagonal);
+	stochNextValue = x + eqnIncrement;
+}
+
+void DifferentialEquation::stepRungeKutta()
+{
+	double x = stochCurrentValue;
+	eqnIncrement = stepEulerTerms(x);
+	
+	// supporting value for the products f_k' f_j dY_j dY_k
+	double support = x;
+	for (uint n=0; n<eqnDiffusive.size(); ++n)
+		support += eqnDiffusiveValues[n] * eqnIntegrators[eqnDiffusive[n]]->d();
+	
+	// differences replace the derivatives, central ones on the diagonal to keep the mean error small
+	double products = 0.0, diagonal = 0.0;
+	for (uint n=0; n<eqnDiffusive.size(); ++n) {
+		StochasticFunction *integrand = eqnIntegrands[eqnDiffusive[n]];
+		double root = sqrt(eqnDiffusiveQV[n]);
+		double h = eqnDiffusiveValues[n] * root;
+		products += ((*integrand)(support) - eqnDiffusiveValues[n]) * eqnIntegrators[eqnDiffusive[n]]->d();
+		diagonal += 0.5 * ((*integrand)(x + h) - (*integrand)(x - h)) * root;
+		(*integrand)(x);   // evaluating sets the integrand's input, put it back to x, as getDerivative() does
+	}
+	eqnIncrement += 0.5 * (products - diagonal);
+	stochNextValue = x + eqnIncrement;
+}
+
+double DifferentialEquation::getQuadraticVariation()
+{
+	double qv = 0.0;
+	for (int i=0; i<eqnTermAmount; ++i) {
+		double integrand = (*eqnIntegrands[i])(stochCurrentValue);
+		qv += integrand * integrand * eqnIntegrators[i]->getQuadraticVariation();
+	}
+	return qv;
+}
+
+bool DifferentialEquation::getDiffusion(double x, double &offset, double &slope, double &variance)
+{
+	updateTermKinds();
+	
+	// same sums as in stepExponential(), but per unit time and without random numbers
+	double dt = xTime->dt;
+	offset = slope = variance = 0.0;
+	for (int i=0; i<eqnTermAmount; ++i) {
+		double a, b;
+		if (!eqnIntegrands[i]->getAffine(a, b) || eqnTermKinds[i]==TERM_OTHER)
+			return false;
+		double rate = 1.0;
+		if (eqnTermKinds[i]==TERM_WIENER) {
+			rate = static_cast<Wiener *>(eqnIntegrators[i])->getMean() / dt;
+			variance += (a + b*x) * (a + b*x) * eqnIntegrators[i]->getQuadraticVariation() / dt;
+		}
+		offset += a * rate;
+		slope += b * rate;
+	}
+	return true;
+}
+
+void DifferentialEquation::updateTermKinds()
+{
+	// sort integrators once after the terms changed
+	if (!eqnTermKindsValid) {
+		eqnTermKinds.resize(eqnTermAmount);
+		for (int i=0; i<eqnTermAmount; ++i) {
+			if (dynamic_cast<TimeProcess *>(eqnIntegrators[i]))
+				eqnTermKinds[i] = TERM_TIME;
+			else if (dynamic_cast<Wiener *>(eqnIntegrators[i]))
+				eqnTermKinds[i] = TERM_WIENER;
+			else
+				eqnTermKinds[i] = TERM_OTHER;
+		}
+		eqnTermKindsValid = true;
+	}
+}
+
+void DifferentialEquation::stepAdaptive()
+{
+	updateTermKinds();
+	
+	// the diffusive terms get a Brownian bridge, their increments are the root of the tree
+	eqnDiffusive.clear();
+	eqnDiffusiveQV.clear();
+	eqnDiffusiveIndex.assign(eqnTermAmount, -1);
+	for (int i=0; i<eqnTermAmount; ++i) {
+		double qv = eqnIntegrators[i]->getQuadraticVariation();
+		if (qv > 0.0) {
+			eqnDiffusiveIndex[i] = eqnDiffusive.size();
+			eqnDiffusive.push_back(i);
+			eqnDiffusiveQV.push_back(qv);
+		}
+	}
+	uint nd = eqnDiffusive.size();
+	eqnBridgeIncrements.resize((2*eqnDepth + 3) * nd);
+	for (uint n=0; n<nd; ++n)
+		eqnBridgeIncrements[n] = eqnIntegrators[eqnDiffusive[n]]->d();
+	
+	eqnSubsteps = 0;
+	stochNextValue = stepAdaptiveInterval(stochCurrentValue, 1.0, 0, &eqnBridgeIncrements[0], true);
+	eqnIncrement = stochNextValue - stochCurrentValue;
+}
+
+double DifferentialEquation::stepAdaptiveInterval(double x, double fraction, int depth, const double *increments, bool first)
+{
+	uint nd = eqnDiffusive.size();
+	double full = stepSubstep(x, fraction, increments, first);
+	
+	// split the increments at the midpoint, conditioned on their sum
+	double *left = &eqnBridgeIncrements[(2*depth + 1) * nd];
+	double *right = left + nd;
+	for (uint n=0; n<nd; ++n) {
+		left[n] = 0.5 * increments[n] + 0.5 * sqrt(eqnDiffusiveQV[n] * fraction) * eqnBridge->dRandN();
+		right[n] = increments[n] - left[n];
+	}
+	double half = 0.5 * fraction;
+	double middle = stepSubstep(x, half, left, first);
+	double end = stepSubstep(middle, half, right, false);
+	
+	if (fabs(end - full) <= eqnTolerance || depth >= eqnDepth) {
+		eqnSubsteps += 2;
+		return end;
+	}
+	
+	// refine both halves on the same path
+	x = stepAdaptiveInterval(x, half, depth + 1, left, first);
+	return stepAdaptiveInterval(x, half, depth + 1, right, false);
+}
+
+double DifferentialEquation::stepSubstep(double x, double fraction, const double *increments, bool first)
+{
+	double increment = 0.0, derivatives = 0.0, values = 0.0, diagonal = 0.0;
+	for (int i=0; i<eqnTermAmount; ++i) {
+		int n = eqnDiffusiveIndex[i];
+		if (n >= 0) {
+			double value = (*eqnIntegrands[i])(x);
+			double derivative = eqnIntegrands[i]->getDerivative(x);
+			derivatives += derivative * increments[n];
+			values += value * increments[n];
+			diagonal += derivative * value * eqnDiffusiveQV[n] * fraction;
+		}
+		else if (eqnTermKinds[i] == TERM_TIME)
+			increment += (*eqnIntegrands[i])(x) * eqnIntegrators[i]->d() * fraction;
+		else if (first)
+			increment += (*eqnIntegrands[i])(x) * eqnIntegrators[i]->d();
+	}
+	return x + increment + values + 0.5 * (derivatives * values - diagonal);
+}
+
+void DifferentialEquation::stepExponential()
+{
+	updateTermKinds();
+	
+	// collect the linear drift A + B*X (per step), the noise and the jumps
+	double x = stochCurrentValue;
+	double drift = 0.0, rate = 0.0, noise = 0.0, jumps = 0.0;
+	for (int i=0; i<eqnTermAmount; ++i) {
+		double offset, slope;
+		double increment = eqnIntegrators[i]->d();
+		if (!eqnIntegrands[i]->getAffine(offset, slope) || eqnTermKinds[i]==TERM_OTHER) {
+			jumps += (*eqnIntegrands[i])(x) * increment;
+			continue;
+		}
+		if (eqnTermKinds[i]==TERM_WIENER) {
+			double mean = static_cast<Wiener *>(eqnIntegrators[i])->getMean();
+			noise += (offset + slope * x) * (increment - mean);
+			increment = mean;
+		}
+		drift += offset * increment;
+		rate += slope * increment;
+	}
+	
+	// coefficients of the exact solution only change with the decay rate
+	if (rate != eqnExpRate) {
+		eqnExpRate = rate;
+		if (fabs(rate) < 1e-8) {
+			eqnExpDecay = 1.0 + rate;
+			eqnExpDrift = 1.0 + 0.5 * rate;
+			eqnExpNoise = sqrt(1.0 + rate);
+		}
+		else {
+			eqnExpDecay = exp(rate);
+			eqnExpDrift = expm1(rate) / rate;
+			eqnExpNoise = sqrt(expm1(2.0 * rate) / (2.0 * rate));
+		}
+	}
+	
+	stochNextValue = eqnExpDecay * x + eqnExpDrift * drift + eqnExpNoise * noise + jumps;
+	eqnIncrement = stochNextValue - x;
+}
+
 
 //______________________________________________________________
 //  set and get current integrating mode
@@ -265,14 +534,67 @@ bool DifferentialEquation::isStratonovich() const
 	else return false;
 }
 
+bool DifferentialEquation::isExponential() const
+{
+	if (eqnMethodPtr == &DifferentialEquation::stepExponential)
+		return true;
+	else return false;
+}
+
+bool DifferentialEquation::isMilstein() const
+{
+	if (eqnMethodPtr == &DifferentialEquation::stepMilstein)
+		return true;
+	else return false;
+}
+
+bool DifferentialEquation::isRungeKutta() const
+{
+	if (eqnMethodPtr == &DifferentialEquation::stepRungeKutta)
+		return true;
+	else return false;
+}
+
+bool DifferentialEquation::isAdaptive() const
+{
+	if (eqnMethodPtr == &DifferentialEquation::stepAdaptive)
+		return true;
+	else return false;
+}
+
 void DifferentialEquation::setIto()
 {
 	eqnMethodPtr = &DifferentialEquation::stepEulerIto;
 }
 
-void DifferentialEquation::setStratonovich()
+void DifferentialEquation::setStratonovich(int iterations)
 {
 	eqnMethodPtr = &DifferentialEquation::stepEulerStratonovich;
+	eqnIterations = iterations;
+}
+
+void DifferentialEquation::setMilstein()
+{
+	eqnMethodPtr = &DifferentialEquation::stepMilstein;
+}
+
+void DifferentialEquation::setRungeKutta()
+{
+	eqnMethodPtr = &DifferentialEquation::stepRungeKutta;
+}
+
+void DifferentialEquation::setAdaptive(double tolerance, int depth)
+{
+	eqnTolerance = tolerance;
+	eqnDepth = depth;
+	if (!eqnBridge)
+		eqnBridge = new RandN(xTime);
+	eqnMethodPtr = &DifferentialEquation::stepAdaptive;
+}
+
+void DifferentialEquation::setExponential()
+{
+	eqnMethodPtr = &DifferentialEquation::stepExponential;
 }
 
 
@@ -298,8 +620,24 @@ string DifferentialEquation::getParameter( const string& name ) const
 		param << getStartingValue();
 	
 	// mode
-	else if (name=="mode")
-		param << (isIto() ? "ito" : "stratonovitch");
+	else if (name=="mode") {
+		if (isIto()) param << "ito";
+		else if (isStratonovich()) param << "stratonovitch";
+		else if (isExponential()) param << "exponential";
+		else if (isMilstein()) param << "milstein";
+		else if (isRungeKutta()) param << "runge-kutta";
+		else if (isAdaptive()) param << "adaptive";
+	}
+	
+	// adaptive mode
+	else if (name=="tolerance")
+		param << eqnTolerance;
+	else if (name=="depth")
+		param << eqnDepth;
+	
+	// fixed-point iterations
+	else if (name=="iterations")
+		param << eqnIterations;
 	
 	// parameters for single terms
 	else {
@@ -349,6 +687,30 @@ void DifferentialEquation::setParameter( const string& name, const string& value
 		if (value=="ito")
 			setIto();
 		if (value=="stratonovitch")
-			setStratonovich();
+			setStratonovich(eqnIterations);
+		if (value=="exponential")
+			setExponential();
+		if (value=="milstein")
+			setMilstein();
+		if (value=="runge-kutta")
+			setRungeKutta();
+		if (value=="adaptive")
+			setAdaptive(eqnTolerance, eqnDepth);
+	}
+	
+	// adaptive mode
+	else if (name=="tolerance") {
+		setting << value;
+		setting >> eqnTolerance;
+	}
+	else if (name=="depth") {
+		setting << value;
+		setting >> eqnDepth;
+	}
+	
+	// fixed-point iterations
+	else if (name=="iterations") {
+		setting << value;
+		setting >> eqnIterations;
 	}
 }
@@ -0,0 +1,252 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#include "../h/ensemble.hxx"
+#include "../h/ifneuron.hxx"
+#include "../h/processes.hxx"
+#include "../h/wiener.hxx"
+
+#include <algorithm>
+#include <map>
+
+
+//____________________________________________________________________________
+//
+//  construct
+//
+
+Ensemble::Ensemble(Time *time, DifferentialEquation *equation, uint lanes)
+	: TimeDependent(time), RandN(time)
+{
+	ensembleEquation = equation;
+	ensembleNeuron = 0;
+	ensembleLanes = lanes;
+	init();
+}
+
+Ensemble::Ensemble(Time *time, IfNeuron *neuron, uint lanes)
+	: TimeDependent(time), RandN(time)
+{
+	ensembleEquation = &neuron->ifneuronMembrane;
+	ensembleNeuron = neuron;
+	ensembleLanes = lanes;
+	init();
+}
+
+
+//____________________________________________________________________________
+//
+//  read the model
+//
+
+void Ensemble::compile()
+{
+	ensembleX0 = ensembleEquation->getStartingValue();
+	ensembleStratonovich = ensembleEquation->isStratonovich();
+	ensembleIterations = ensembleEquation->getIterations();
+	if (ensembleNeuron) {
+		ensembleTheta = ensembleNeuron->ifneuronTheta;
+		ensembleSpikeHeight = ensembleNeuron->ifneuronSpikeHeight;
+	}
+	
+	ensembleOffsets.clear();
+	ensembleSlopes.clear();
+	ensembleTermSources.clear();
+	ensembleSourceTypes.clear();
+	ensembleSourceMeans.clear();
+	ensembleSourceStdDevs.clear();
+	
+	// one source for each integrator, even if used in several terms
+	map<StochasticVariable *, uint> sources;
+	for (int i=0; i<ensembleEquation->getNTerms(); ++i) {
+		StochasticFunction *integrand = ensembleEquation->getIntegrand(i);
+		StochasticVariable *integrator = ensembleEquation->getIntegrator(i);
+		double offset, slope;
+		if (!integrand->getAffine(offset, slope)) {
+			cout << "ensemble: integrand " << integrand->getName() << " (" << integrand->getType() << ") is not affine, term " << i << " is ignored" << endl;
+			continue;
+		}
+		
+		if (!sources.count(integrator)) {
+			double dt = integrator->getTime()->dt;
+			Wiener *wiener = dynamic_cast<Wiener *>(integrator);
+			Poisson *poisson = dynamic_cast<Poisson *>(integrator);
+			if (dynamic_cast<TimeProcess *>(integrator)) {
+				ensembleSourceTypes.push_back(SOURCE_TIME);
+				ensembleSourceMeans.push_back(dt);
+				ensembleSourceStdDevs.push_back(0.0);
+			}
+			else if (wiener) {
+				ensembleSourceTypes.push_back(SOURCE_WIENER);
+				ensembleSourceMeans.push_back(wiener->getMean());
+				ensembleSourceStdDevs.push_back(wiener->getStdDev() * sqrt(dt));
+			}
+			else if (poisson) {
+				ensembleSourceTypes.push_back(SOURCE_POISSON);
+				ensembleSourceMeans.push_back(poisson->getRate() * dt);
+				ensembleSourceStdDevs.push_back(0.0);
+			}
+			else {
+				cout << "ensemble: integrator " << integrator->getName() << " (" << integrator->getType() << ") is not supported, term " << i << " is ignored" << endl;
+				continue;
+			}
+			sources[integrator] = ensembleSourceTypes.size() - 1;
+		}
+		
+		ensembleOffsets.push_back(offset);
+		ensembleSlopes.push_back(slope);
+		ensembleTermSources.push_back(sources[integrator]);
+	}
+	
+	ensembleIncrements.assign(ensembleSourceTypes.size(), vector<double>(ensembleLanes, 0.0));
+}
+
+
+//____________________________________________________________________________
+//
+//  reset all lanes
+//
+
+void Ensemble::init()
+{
+	compile();
+	ensembleCurrent.assign(ensembleLanes, ensembleX0);
+	ensembleNext.assign(ensembleLanes, ensembleX0);
+	ensembleValueCurrent.assign(ensembleLanes, ensembleX0);
+	ensembleValueNext.assign(ensembleLanes, ensembleX0);
+	ensembleEventCurrent.assign(ensembleLanes, 0);
+	ensembleEventNext.assign(ensembleLanes, 0);
+	ensembleSum.assign(ensembleLanes, 0.0);
+	ensembleDrift.assign(ensembleLanes, 0.0);
+	ensembleNextStateIsPrepared = false;
+}
+
+
+//____________________________________________________________________________
+//
+//  step all lanes
+//
+
+void Ensemble::prepareNextState()
+{
+	if (ensembleNextStateIsPrepared)
+		return;
+	
+	uint n = ensembleLanes;
+	const double *x = &ensembleCurrent[0];
+	double *next = &ensembleNext[0];
+	double *sum = &ensembleSum[0];
+	
+	// increments of all integrators
+	for (uint s=0; s<ensembleSourceTypes.size(); ++s) {
+		double *d = &ensembleIncrements[s][0];
+		double mean = ensembleSourceMeans[s];
+		double stddev = ensembleSourceStdDevs[s];
+		if (ensembleSourceTypes[s] == SOURCE_WIENER) {
+			fillN(d, n);
+			for (uint l=0; l<n; ++l)
+				d[l] = stddev * d[l] + mean;
+		}
+		else if (ensembleSourceTypes[s] == SOURCE_POISSON) {
+			fillE(d, n);
+			for (uint l=0; l<n; ++l)
+				d[l] = d[l] < mean ? 1.0 : 0.0;
+		}
+	}
+	
+	// Ito sum, one term at a time over all lanes
+	fill(ensembleSum.begin(), ensembleSum.end(), 0.0);
+	for (uint t=0; t<ensembleOffsets.size(); ++t) {
+		double a = ensembleOffsets[t];
+		double b = ensembleSlopes[t];
+		uint s = ensembleTermSources[t];
+		if (ensembleSourceTypes[s] == SOURCE_TIME) {
+			double dt = ensembleSourceMeans[s];
+			for (uint l=0; l<n; ++l)
+				sum[l] += (a + b * x[l]) * dt;
+		}
+		else {
+			const double *d = &ensembleIncrements[s][0];
+			for (uint l=0; l<n; ++l)
+				sum[l] += (a + b * x[l]) * d[l];
+		}
+	}
+	for (uint l=0; l<n; ++l)
+		next[l] = x[l] + sum[l];
+	
+	// Stratonovich correction, the same fixed point iteration as in DifferentialEquation
+	if (ensembleStratonovich) {
+		double *drift = &ensembleDrift[0];
+		for (int k=0; k<ensembleIterations; ++k) {
+			fill(ensembleDrift.begin(), ensembleDrift.end(), 0.0);
+			for (uint t=0; t<ensembleOffsets.size(); ++t) {
+				double b = ensembleSlopes[t];
+				uint s = ensembleTermSources[t];
+				if (ensembleSourceTypes[s] == SOURCE_TIME) {
+					double dt = ensembleSourceMeans[s];
+					for (uint l=0; l<n; ++l)
+						drift[l] += b * (next[l] - x[l]) * dt;
+				}
+				else {
+					const double *d = &ensembleIncrements[s][0];
+					for (uint l=0; l<n; ++l)
+						drift[l] += b * (next[l] - x[l]) * d[l];
+				}
+			}
+			for (uint l=0; l<n; ++l)
+				next[l] = x[l] + sum[l] + 0.5 * drift[l];
+		}
+	}
+	
+	// threshold and reset, as in IfNeuron::prepareNextState()
+	if (ensembleNeuron) {
+		const char *event = &ensembleEventCurrent[0];
+		char *eventNext = &ensembleEventNext[0];
+		double *value = &ensembleValueNext[0];
+		double theta = ensembleTheta;
+		double reset = ensembleX0;
+		double height = ensembleSpikeHeight;
+		for (uint l=0; l<n; ++l) {
+			char fired = !event[l] && next[l] > theta;
+			next[l] = event[l] ? reset : next[l];
+			value[l] = fired ? height : next[l];
+			eventNext[l] = fired;
+		}
+	}
+	
+	ensembleNextStateIsPrepared = true;
+}
+
+
+//____________________________________________________________________________
+//
+//  advance all lanes
+//
+
+void Ensemble::proceedToNextState()
+{
+	ensembleCurrent.swap(ensembleNext);
+	ensembleValueCurrent.swap(ensembleValueNext);
+	ensembleEventCurrent.swap(ensembleEventNext);
+	ensembleNextStateIsPrepared = false;
+}
@@ -0,0 +1,110 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#include "../h/ensembleestimator.hxx"
+#include <math.h>
+
+//________________________________________________________________________
+//
+//  ensemble estimator
+//
+
+EnsembleEstimator::EnsembleEstimator(const Property& property, Ensemble *ensemble, Time *time)
+	: ScalarEstimator( property, 0, time )
+{
+	pEnsemble = ensemble;
+}
+
+EnsembleEstimator::~EnsembleEstimator()
+{}
+
+void EnsembleEstimator::collect()
+{
+	uint n = pEnsemble->getLanes();
+	const double *x = pEnsemble->getCurrentValues();
+	const double *next = pEnsemble->getNextValues();
+	bool diff = nEstimate & EST_DIFF;
+	
+	// moments over all lanes
+	double one = 0.0, two = 0.0, three = 0.0;
+	for (uint l=0; l<n; ++l) {
+		double d = diff ? next[l] - x[l] : x[l];
+		one += d;
+		two += d*d;
+		three += d*d*d;
+	}
+	nSamples += n;
+	if (nEstimate & EST_SAMPLE)
+		dSample = diff ? next[0] - x[0] : x[0];
+	if (nEstimate & EST_MEAN)
+		dOne += one;
+	if (nEstimate & EST_VAR)
+		dTwo += two;
+	if (nEstimate & EST_CUR)
+		dThree += three;
+	
+	// density
+	if (nEstimate & EST_DENS)
+		for (uint l=0; l<n; ++l) {
+			double d = diff ? next[l] - x[l] : x[l];
+			int bin = (int) floor( (d - dDistOffset) / dDistScale + 0.5); // round
+			if( (bin < nDist) && (bin >= 0) )
+				aDist[ bin ]++;
+		}
+}
+
+
+//________________________________________________________________________
+//
+//  ensemble interval estimator
+//
+
+EnsembleIntervalEstimator::EnsembleIntervalEstimator(const Property& property, Ensemble *ensemble, Time *time)
+	: ScalarEstimator( property, 0, time )
+{
+	pEnsemble = ensemble;
+	aTime.assign( pEnsemble->getLanes(), -1 );
+}
+
+EnsembleIntervalEstimator::~EnsembleIntervalEstimator()
+{}
+
+void EnsembleIntervalEstimator::collect()
+{
+	uint n = pEnsemble->getLanes();
+	const char *event = pEnsemble->getEvents();
+	double dt = estimatorTime->dt;
+	for (uint l=0; l<n; ++l) {
+		++aTime[l];
+		if (event[l]) {
+			estimate( dt * double(aTime[l]) );
+			aTime[l] = 0;
+		}
+	}
+}
+
+void EnsembleIntervalEstimator::init()
+{
+	ScalarEstimator::init();
+	aTime.assign( pEnsemble->getLanes(), -1 );
+}
@@ -23,3 +23,11 @@ Estimator::Estimator(StochasticProcess *src, Time *time, const string& name, con
 	estimatorTime->add( this );
 };
 
+
+//__________________________________________________________________________
+// merge
+
+void Estimator::merge( Estimator *other )
+{
+	cout << "estimator " << getType() << " can't merge results" << endl;
+}
@@ -0,0 +1,372 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#include "../h/eventdrivennetwork.hxx"
+
+#include <cmath>
+
+
+//____________________________________________________________________________
+//
+//  single-cell view
+//
+
+EventDrivenNeuron::EventDrivenNeuron(EventDrivenNetwork *network, uint index)
+	: StochasticEventGenerator(network->getTime(), "", "Event Driven Neuron")
+{
+	neuronNetwork = network;
+	neuronIndex = index;
+	init();
+}
+
+void EventDrivenNeuron::getDependencies( vector<TimeDependent *> &dependencies )
+{
+	dependencies.push_back(neuronNetwork);
+}
+
+void EventDrivenNeuron::prepareNextState()
+{
+	stochNextStateIsPrepared = neuronNetwork->isNextStatePrepared();
+	if (stochNextStateIsPrepared) {
+		neuronEventAmountNext = neuronNetwork->networkStepSpikes[neuronIndex];
+		eventNextValue = neuronEventAmountNext > 0;
+		eventNextOffset = eventNextValue ? neuronNetwork->networkStepOffset[neuronIndex] : 0.0;
+		stochNextValue = eventNextValue ? neuronNetwork->networkSpikeHeight : neuronNetwork->voltage(neuronIndex, neuronNetwork->networkNextClock);
+	}
+}
+
+void EventDrivenNeuron::proceedToNextState()
+{
+	if (stochNextStateIsPrepared)
+		neuronEventAmount = neuronEventAmountNext;
+	StochasticEventGenerator::proceedToNextState();
+}
+
+void EventDrivenNeuron::init()
+{
+	stochCurrentValue = stochNextValue = neuronNetwork->networkReset[neuronIndex];
+	eventCurrentValue = eventNextValue = false;
+	eventCurrentOffset = eventNextOffset = 0.0;
+	neuronEventAmount = neuronEventAmountNext = 0;
+}
+
+
+//____________________________________________________________________________
+//
+//  construct / destroy
+//
+
+EventDrivenNetwork::EventDrivenNetwork(Time *time, uint size, double v0, double theta, double spikeheight, double tau, double v_rest)
+	: TimeDependent(time), RandN(time)
+{
+	networkSize = size;
+	networkSpikeHeight = spikeheight;
+	networkRefractoryPeriod = 0.0;
+	networkNextStateIsPrepared = false;
+	networkConnectionsValid = false;
+	
+	networkTheta.assign(size, theta);
+	networkReset.assign(size, v0);
+	networkRest.assign(size, v_rest);
+	networkTau.assign(size, tau);
+	networkBias.assign(size, 0.0);
+	networkViews.assign(size, (EventDrivenNeuron *)0);
+	
+	init();
+}
+
+EventDrivenNetwork::~EventDrivenNetwork()
+{
+	for (uint i=0; i<networkSize; ++i)
+		if (networkViews[i])
+			delete networkViews[i];
+}
+
+
+//____________________________________________________________________________
+//
+//  parameters
+//
+
+void EventDrivenNetwork::setThreshold(uint cell, double theta)
+{
+	networkTheta[cell] = theta;
+}
+
+void EventDrivenNetwork::setReset(uint cell, double v0)
+{
+	networkReset[cell] = v0;
+}
+
+void EventDrivenNetwork::setLeak(uint cell, double v_rest, double tau)
+{
+	networkRest[cell] = v_rest;
+	networkTau[cell] = tau;
+}
+
+void EventDrivenNetwork::setBias(double mean)
+{
+	networkBias.assign(networkSize, mean);
+}
+
+void EventDrivenNetwork::setBias(uint cell, double mean)
+{
+	networkBias[cell] = mean;
+}
+
+void EventDrivenNetwork::setRefractoryPeriod(double period)
+{
+	networkRefractoryPeriod = period;
+}
+
+
+//____________________________________________________________________________
+//
+//  inputs and connections
+//
+
+uint EventDrivenNetwork::addPoissonInput(uint cell, double rate, double weight)
+{
+	networkInputCells.push_back(cell);
+	networkInputRates.push_back(rate);
+	networkInputWeights.push_back(weight);
+	return networkInputCells.size() - 1;
+}
+
+void EventDrivenNetwork::connect(uint pre, uint post, double weight, double delay)
+{
+	if (pre >= networkSize || post >= networkSize) {
+		cout << "EventDrivenNetwork::connect: cell out of range" << endl;
+		return;
+	}
+	networkPre.push_back(pre);
+	networkPost.push_back(post);
+	networkEdgeWeights.push_back(weight);
+	networkEdgeDelays.push_back(delay < 0.0 ? 0.0 : delay);
+	networkConnectionsValid = false;
+}
+
+void EventDrivenNetwork::connect(const vector<uint> &pre, const vector<uint> &post, const vector<double> &weights, const vector<double> &delays)
+{
+	if (post.size() != pre.size() || weights.size() != pre.size() || delays.size() != pre.size()) {
+		cout << "EventDrivenNetwork::connect: edge lists differ in length" << endl;
+		return;
+	}
+	for (uint k=0; k<pre.size(); ++k)
+		connect(pre[k], post[k], weights[k], delays[k]);
+}
+
+void EventDrivenNetwork::buildConnections()
+{
+	// counting sort into rows
+	uint edges = networkPre.size();
+	networkRows.assign(networkSize + 1, 0);
+	for (uint k=0; k<edges; ++k)
+		++networkRows[networkPre[k] + 1];
+	for (uint i=0; i<networkSize; ++i)
+		networkRows[i + 1] += networkRows[i];
+	vector<uint> next(networkRows.begin(), networkRows.end() - 1);
+	networkTargets.resize(edges);
+	networkWeights.resize(edges);
+	networkDelays.resize(edges);
+	for (uint k=0; k<edges; ++k) {
+		uint e = next[networkPre[k]]++;
+		networkTargets[e] = networkPost[k];
+		networkWeights[e] = networkEdgeWeights[k];
+		networkDelays[e] = networkEdgeDelays[k];
+	}
+	networkConnectionsValid = true;
+}
+
+EventDrivenNeuron *EventDrivenNetwork::getNeuron(uint cell)
+{
+	if (cell >= networkSize) {
+		cout << "EventDrivenNetwork::getNeuron: cell " << cell << " out of range" << endl;
+		return 0;
+	}
+	if (!networkViews[cell])
+		networkViews[cell] = new EventDrivenNeuron(this, cell);
+	return networkViews[cell];
+}
+
+
+//____________________________________________________________________________
+//
+//  events
+//
+
+void EventDrivenNetwork::update(uint cell, double t, double v)
+{
+	networkVoltage[cell] = v;
+	networkUpdate[cell] = t;
+	uint version = ++networkVersion[cell];
+	
+	// crossing towards the fixed point
+	double target = networkRest[cell] + networkTau[cell] * networkBias[cell];
+	double theta = networkTheta[cell];
+	if (target > theta && v < theta) {
+		Event e;
+		e.time = t + networkTau[cell] * log((v - target) / (theta - target));
+		e.kind = EVENT_THRESHOLD;
+		e.index = cell;
+		e.version = version;
+		networkQueue.push(e);
+	}
+}
+
+void EventDrivenNetwork::spike(uint cell, double t, double stepEnd)
+{
+	++networkSpikeCount[cell];
+	if (stepEnd >= 0.0) {
+		if (!networkStepSpikes[cell]++)
+			networkSpiking.push_back(cell);
+		networkStepOffset[cell] = (stepEnd - t) / xTime->dt;
+	}
+	
+	// reset, held for the refractory period
+	update(cell, t + networkRefractoryPeriod, networkReset[cell]);
+	
+	// send along the connections
+	Event e;
+	e.kind = EVENT_ARRIVAL;
+	e.version = 0;
+	for (uint k=networkRows[cell]; k<networkRows[cell + 1]; ++k) {
+		e.time = t + networkDelays[k];
+		e.index = k;
+		networkQueue.push(e);
+	}
+}
+
+void EventDrivenNetwork::scheduleInput(uint input, double t)
+{
+	double rate = networkInputRates[input];
+	if (rate <= 0.0)
+		return;
+	Event e;
+	e.time = t - log(1.0 - dRandE()) / rate;
+	e.kind = EVENT_INPUT;
+	e.index = input;
+	e.version = 0;
+	networkQueue.push(e);
+}
+
+void EventDrivenNetwork::process(double t, double stepEnd)
+{
+	while (!networkQueue.empty() && networkQueue.top().time <= t) {
+		Event e = networkQueue.top();
+		networkQueue.pop();
+		
+		uint cell;
+		double weight;
+		switch (e.kind) {
+		case EVENT_THRESHOLD:
+			if (e.version == networkVersion[e.index])
+				spike(e.index, e.time, stepEnd);
+			continue;
+		case EVENT_INPUT:
+			cell = networkInputCells[e.index];
+			weight = networkInputWeights[e.index];
+			scheduleInput(e.index, e.time);
+			break;
+		case EVENT_ARRIVAL:
+			cell = networkTargets[e.index];
+			weight = networkWeights[e.index];
+			break;
+		default:
+			continue;
+		}
+		
+		// jump, lost during the refractory period
+		if (e.time < networkUpdate[cell])
+			continue;
+		double v = voltage(cell, e.time) + weight;
+		if (v >= networkTheta[cell])
+			spike(cell, e.time, stepEnd);
+		else
+			update(cell, e.time, v);
+	}
+}
+
+void EventDrivenNetwork::advance(double t)
+{
+	process(t, -1.0);
+	networkClock = networkNextClock = t;
+}
+
+
+//____________________________________________________________________________
+//
+//  reset all cells
+//
+
+void EventDrivenNetwork::init()
+{
+	uint n = networkSize;
+	if (!networkConnectionsValid)
+		buildConnections();
+	
+	networkClock = networkNextClock = 0.0;
+	networkQueue = priority_queue<Event, vector<Event>, std::greater<Event> >();
+	networkVoltage.resize(n);
+	networkUpdate.resize(n);
+	networkVersion.assign(n, 0);
+	networkSpikeCount.assign(n, 0);
+	networkStepSpikes.assign(n, 0);
+	networkStepOffset.assign(n, 0.0);
+	networkSpiking.clear();
+	for (uint i=0; i<n; ++i)
+		update(i, 0.0, networkReset[i]);
+	for (uint i=0; i<networkInputCells.size(); ++i)
+		scheduleInput(i, 0.0);
+	networkNextStateIsPrepared = false;
+	
+	for (uint i=0; i<n; ++i)
+		if (networkViews[i])
+			networkViews[i]->init();
+}
+
+
+//____________________________________________________________________________
+//
+//  time steps
+//
+
+void EventDrivenNetwork::prepareNextState()
+{
+	if (networkNextStateIsPrepared)
+		return;
+	networkNextClock = networkClock + xTime->dt;
+	process(networkNextClock, networkNextClock);
+	networkNextStateIsPrepared = true;
+}
+
+void EventDrivenNetwork::proceedToNextState()
+{
+	if (!networkNextStateIsPrepared)
+		return;
+	networkClock = networkNextClock;
+	for (uint i=0; i<networkSpiking.size(); ++i)
+		networkStepSpikes[networkSpiking[i]] = 0;
+	networkSpiking.clear();
+	networkNextStateIsPrepared = false;
+}
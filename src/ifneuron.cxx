@@ -32,6 +32,7 @@ IfNeuron::IfNeuron(Time *time, double v_0, double theta, double spikeheight, dou
 	addParameter("threshold");
 	addParameter("spike-height");
 	addParameter("membrane");
+	addParameter("crossing-correction");
 	
 	// write descriptions
 	physicalDescription = "voltage";
@@ -42,6 +43,8 @@ IfNeuron::IfNeuron(Time *time, double v_0, double theta, double spikeheight, dou
 	eventCurrentValue = false;
 	eventNextValue = false;
 	ifneuronTheta = theta;	
+	ifneuronCrossing = false;
+	ifneuronBridge = 0;
 	ifneuronMembrane.setUnit( Unit("m","V") * Unit("u","F") );
 	physicalUnit = Unit("m","V");
 	
@@ -50,7 +53,10 @@ IfNeuron::IfNeuron(Time *time, double v_0, double theta, double spikeheight, dou
 }
 
 IfNeuron::~IfNeuron()
-{}
+{
+	if (ifneuronBridge)
+		delete ifneuronBridge;
+}
 
 void IfNeuron::prepareNextState()
 {
@@ -61,19 +67,44 @@ void IfNeuron::prepareNextState()
 	
 	// proceed if calculation was successful
 	if (stochNextStateIsPrepared) {
-		if (eventNextValue) {
+		if (eventNextValue && !ifneuronCrossing) {
 			ifneuronMembrane.init();
 			stochNextValue = ifneuronMembrane.getNextValue();
 			eventNextValue = false;
 		} else {
+			eventNextValue = false;
+			double current = ifneuronMembrane.getCurrentValue();
 			if (stochNextValue>ifneuronTheta) {
+				// interpolate the spike time
+				eventNextOffset = ifneuronCrossing ? (stochNextValue - ifneuronTheta) / (stochNextValue - current) : 0.0;
 				stochNextValue = ifneuronSpikeHeight;
 				eventNextValue = true;
 			}
+			else if (ifneuronCrossing) {
+				// exit probability of the Brownian bridge between both values
+				double variance = ifneuronMembrane.getQuadraticVariation();
+				double distance = (ifneuronTheta - current) * (ifneuronTheta - stochNextValue);
+				if (variance > 0.0 && ifneuronBridge->dRandE() < exp(-2.0 * distance / variance)) {
+					eventNextOffset = (ifneuronTheta - stochNextValue) / (2.0*ifneuronTheta - current - stochNextValue);
+					stochNextValue = ifneuronSpikeHeight;
+					eventNextValue = true;
+				}
+			}
+			
+			// with correction the membrane is reset at the spike, no time step is lost
+			if (eventNextValue && ifneuronCrossing)
+				ifneuronMembrane.setNextValue(ifneuronMembrane.getStartingValue());
 		}
 	}
 }
 
+void IfNeuron::setCrossingCorrection(bool correction)
+{
+	ifneuronCrossing = correction;
+	if (correction && !ifneuronBridge)
+		ifneuronBridge = new RandN(xTime);
+}
+
 void IfNeuron::proceedToNextState()
 {
 	SpikingNeuron::proceedToNextState();
@@ -87,57 +118,110 @@ bool IfNeuron::hasEvent()
 
 void IfNeuron::calibrate(int isi, int spikes, int maxtime, NoiseSource *noises, double increment, double decrement)
 {
-	double stepsize = 20.0; // starting stepsize
+	calibrateThreshold(isi, spikes, maxtime, increment, decrement);
+}
+
+void IfNeuron::startCalibration(double &stepsize, double &precision)
+{
 	ifneuronTheta = ifneuronMembrane.getStartingValue();
-	int direction = 1; // current direction 1-up, -1-down
+	stepsize = 20.0;
+	precision = 0.00001;
+}
+
+// scaled complementary error function exp(z^2) erfc(z), safe for large z
+static double erfcScaled(double z)
+{
+	if (z < 3.0)
+		return exp(z*z) * erfc(z);
+	
+	// continued fraction, converges quickly for large arguments
+	double fraction = z;
+	for (int n=40; n>0; --n)
+		fraction = z + 0.5 * n / fraction;
+	return 1.0 / (sqrt(M_PI) * fraction);
+}
+
+// mean first-passage time of an OU process from reset to threshold (Siegert formula)
+static double siegertInterval(double reset, double theta, double mu, double sigma, double tau)
+{
+	if (theta <= reset)
+		return 0.0;
+	
+	// without noise the membrane relaxes deterministically towards the mean
+	if (sigma <= 0.0)
+		return (mu > theta) ? tau * log((mu - reset) / (mu - theta)) : HUGE_VAL;
+	
+	// Simpson quadrature of exp(u^2)(1+erf(u)) = erfcx(-u)
+	const int n = 1000;
+	double lower = (reset - mu) / sigma;
+	double h = ((theta - mu) / sigma - lower) / n;
+	double sum = erfcScaled(-lower) + erfcScaled(-lower - n*h);
+	for (int k=1; k<n; ++k)
+		sum += (k%2 ? 4.0 : 2.0) * erfcScaled(-lower - k*h);
+	return tau * sqrt(M_PI) * sum * h / 3.0;
+}
+
+// threshold at which the Siegert interval has the given value, by bisection
+static double siegertThreshold(double interval, double reset, double mu, double sigma, double tau)
+{
+	// find an upper bound, the interval grows monotonically with the threshold
+	double scale = (sigma > 0.0) ? sigma : fabs(mu - reset) + 1.0;
+	double lower = reset, upper = max(reset, mu) + scale;
+	while (siegertInterval(reset, upper, mu, sigma, tau) < interval && upper - reset < 1e6 * scale) {
+		lower = upper;
+		upper += 2.0 * (upper - reset);
+	}
+	
+	for (int k=0; k<100 && upper - lower > 1e-10 * scale; ++k) {
+		double middle = 0.5 * (lower + upper);
+		if (siegertInterval(reset, middle, mu, sigma, tau) < interval)
+			lower = middle;
+		else
+			upper = middle;
+	}
+	return 0.5 * (lower + upper);
+}
 
-	// new interval estimator, measuring time in units
-	IntervalEstimator estimator(EST_MEAN, this, xTime);
+bool IfNeuron::calibrateSiegert(int isi, int spikes, int maxtime)
+{
+	// the membrane must be a linear SDE driven by Wiener processes
+	double offset, slope, variance;
+	if (!ifneuronMembrane.getDiffusion(0.0, offset, slope, variance) || slope >= 0.0) {
+		cout << "membrane is not an Ornstein-Uhlenbeck process, calibrating by simulation." << endl;
+		calibrate(isi, spikes, maxtime);
+		return false;
+	}
+	double tau = -1.0 / slope;
+	double mu = offset * tau;
+	ifneuronMembrane.getDiffusion(mu, offset, slope, variance);
+	double sigma = sqrt(variance * tau);
+	double reset = ifneuronMembrane.getStartingValue();
+	
+	// without correction the reset takes one time step
+	double dt = xTime->dt;
+	double target = isi * dt - (ifneuronCrossing ? 0.0 : dt);
+	ifneuronTheta = siegertThreshold(target, reset, mu, sigma, tau);
 	
+	// verify with a short simulation
+	IntervalEstimator estimator(EST_MEAN|EST_VAR, this, xTime);
 	NullStream devnull;
+	xTime->run( spikes, this, maxtime, devnull );
+	double mean = estimator.getEstimate(EST_MEAN).to_d();
+	double error = sqrt(estimator.getEstimate(EST_VAR).to_d() / spikes);
 	
-	for( int k=0; k<1000; k++) {
-		
-		// test fpt
-		xTime->run( spikes, this, maxtime, devnull );
-		double mean = estimator.getEstimate(EST_MEAN).to_d() / xTime->dt;
-		if( mean==0.0 ) mean = 1e23;
-		
-		// early stopping
-		if( stepsize<0.00001 ) {
-			cout << "\ncalibrated neuron after " << k << " steps.\t\t\t\t\t" << endl;
-			break;
-		}
+	cout << "calibrated neuron analytically, threshold: " << ifneuronTheta << ", measured spike rate: " << 1.0/mean << " Hz, target rate: " << 1.0/(isi*dt) << " Hz" << endl;
 	
-		// adjust threshold
-		if(mean < isi) {
-			if (direction == 1) {
-				// mean too large and direction up - decrease stepsize and turn
-				stepsize *= decrement;
-				direction *= -1;
-			} else {
-				// mean too large and direction down - increase stepsize and go on
-				stepsize *= increment;
-			}
-		} else {
-			if (direction == -1) {
-				// mean too small and direction down - decrease stepsize and turn
-				stepsize *= decrement;
-				direction *= -1;
-			} else {
-				// mean too small and direction up - increase stepsize and go on
-				stepsize *= increment;
-			}
+	// remove the discretisation bias from the target and solve again
+	if (mean > 0.0 && fabs(mean - isi*dt) > 2.0 * error) {
+		double corrected = target - (mean - isi*dt);
+		if (corrected > 0.0) {
+			ifneuronTheta = siegertThreshold(corrected, reset, mu, sigma, tau);
+			cout << "threshold corrected for time discretisation: " << ifneuronTheta << endl;
 		}
-		
-		// note to the user
-		cout << "\rthreshold: " << ifneuronTheta << ", spike rate: " << 1.0/(mean*xTime->dt) << " Hz, target rate: " << 1.0/(isi*xTime->dt) << " Hz, next correction: " << direction*stepsize << "\t\t\t" << flush;
-
-		// apply correction
-		ifneuronTheta -= direction * stepsize;
 	}
 	
 	init();
+	return true;
 }
 
 string IfNeuron::getParameter(const string& name) const
@@ -153,6 +237,8 @@ string IfNeuron::getParameter(const string& name) const
 		param << ifneuronMembrane.getConfiguration();
 	else if (name=="membrane integration-mode")
 		param << ifneuronMembrane.getParameter("mode");
+	else if (name=="crossing-correction")
+		param << ifneuronCrossing;
 	else
 		return SpikingNeuron::getParameter(name);
 		
@@ -172,6 +258,12 @@ void IfNeuron::setParameter(const string& name, const string& value)
 		setting >> ifneuronSpikeHeight;
 		cout << "setting spike height to " << ifneuronSpikeHeight << endl;
 	}
+	else if (name == "crossing-correction") {
+		bool correction;
+		setting << value;
+		setting >> correction;
+		setCrossingCorrection(correction);
+	}
 	else if (name== "membrane integration-mode") {
 		ifneuronMembrane.setParameter("mode", value);
 	}
@@ -210,6 +302,11 @@ int IfNeuron::addStimulus( Synapse *synapse )
 	return ifneuronMembrane.addTerm( synapse, new TimeProcess(synapse->getTime()) );
 }
 
+int IfNeuron::addStimulus( AggregateConductance *conductance )
+{
+	return ifneuronMembrane.addTerm( conductance, new TimeProcess(conductance->getTime()) );
+}
+
 void IfNeuron::removeStimulus( int n)
 {
 	ifneuronMembrane.rmTerm(n);
@@ -0,0 +1,366 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#include "../h/ifneuronpopulation.hxx"
+#include "../h/processes.hxx"
+#include "../h/synapse.hxx"
+
+#include <algorithm>
+
+
+//____________________________________________________________________________
+//
+//  single-cell view
+//
+
+PopulationNeuron::PopulationNeuron(IfNeuronPopulation *population, uint index)
+	: StochasticEventGenerator(population->getTime(), "", "Population Neuron")
+{
+	neuronPopulation = population;
+	neuronIndex = index;
+	init();
+}
+
+void PopulationNeuron::getDependencies( vector<TimeDependent *> &dependencies )
+{
+	dependencies.push_back(neuronPopulation);
+}
+
+void PopulationNeuron::prepareNextState()
+{
+	stochNextStateIsPrepared = neuronPopulation->isNextStatePrepared();
+	if (stochNextStateIsPrepared) {
+		stochNextValue = neuronPopulation->getNextValues()[neuronIndex];
+		eventNextValue = neuronPopulation->getNextEvents()[neuronIndex];
+	}
+}
+
+void PopulationNeuron::init()
+{
+	stochCurrentValue = stochNextValue = neuronPopulation->populationReset[neuronIndex];
+	eventCurrentValue = eventNextValue = false;
+}
+
+
+//____________________________________________________________________________
+//
+//  construct / destroy
+//
+
+IfNeuronPopulation::IfNeuronPopulation(Time *time, uint size, double v0, double theta, double spikeheight, double tau, double v_rest)
+	: TimeDependent(time), RandN(time)
+{
+	populationSize = size;
+	populationSpikeHeight = spikeheight;
+	populationRefractoryPeriod = 0.0;
+	populationSynapticTau = 5.0;
+	populationCoefficientsValid = false;
+	populationNextStateIsPrepared = false;
+	
+	populationTheta.assign(size, theta);
+	populationReset.assign(size, v0);
+	populationRest.assign(size, v_rest);
+	populationTau.assign(size, tau);
+	populationMean.assign(size, 0.0);
+	populationStdDev.assign(size, 0.0);
+	populationViews.assign(size, (PopulationNeuron *)0);
+	
+	init();
+}
+
+IfNeuronPopulation::~IfNeuronPopulation()
+{
+	for (uint i=0; i<populationSize; ++i)
+		if (populationViews[i])
+			delete populationViews[i];
+	for (uint i=0; i<populationOwned.size(); ++i)
+		delete populationOwned[i];
+}
+
+
+//____________________________________________________________________________
+//
+//  parameters
+//
+
+void IfNeuronPopulation::setThreshold(uint cell, double theta)
+{
+	populationTheta[cell] = theta;
+}
+
+void IfNeuronPopulation::setReset(uint cell, double v0)
+{
+	populationReset[cell] = v0;
+}
+
+void IfNeuronPopulation::setLeak(uint cell, double v_rest, double tau)
+{
+	populationRest[cell] = v_rest;
+	populationTau[cell] = tau;
+	populationCoefficientsValid = false;
+}
+
+void IfNeuronPopulation::setDrive(double mean, double stddev)
+{
+	populationMean.assign(populationSize, mean);
+	populationStdDev.assign(populationSize, stddev);
+	populationCoefficientsValid = false;
+}
+
+void IfNeuronPopulation::setDrive(uint cell, double mean, double stddev)
+{
+	populationMean[cell] = mean;
+	populationStdDev[cell] = stddev;
+	populationCoefficientsValid = false;
+}
+
+void IfNeuronPopulation::setRefractoryPeriod(double period)
+{
+	populationRefractoryPeriod = period;
+}
+
+void IfNeuronPopulation::setSynapticTimeConstant(double tau)
+{
+	populationSynapticTau = tau;
+	populationCoefficientsValid = false;
+}
+
+void IfNeuronPopulation::updateCoefficients()
+{
+	double dt = xTime->dt;
+	populationSynapticDecay = populationSynapticTau > 0.0 ? exp(-dt / populationSynapticTau) : 0.0;
+	for (uint i=0; i<populationSize; ++i) {
+		double tau = populationTau[i];
+		double decay = exp(-dt / tau);
+		populationDecay[i] = decay;
+		populationGain[i] = tau * (1.0 - decay);
+		populationNoiseScale[i] = populationStdDev[i] * sqrt(0.5 * tau * (1.0 - decay * decay));
+	}
+	populationCoefficientsValid = true;
+}
+
+
+//____________________________________________________________________________
+//
+//  inputs
+//
+
+void IfNeuronPopulation::addInput(TimeDependent *input)
+{
+	populationInputs.push_back(input);
+	xTime->invalidateSchedule();
+}
+
+int IfNeuronPopulation::addStimulus(uint cell, StochasticVariable *integrator, double weight)
+{
+	Scalar *integrand = new Scalar(weight, weight < 0 ? "inhibitory" : "excitatory");
+	populationOwned.push_back(integrand);
+	populationStimulusCells.push_back(cell);
+	populationStimulusIntegrands.push_back(integrand);
+	populationStimulusIntegrators.push_back(integrator);
+	xTime->invalidateSchedule();
+	return populationStimulusCells.size() - 1;
+}
+
+int IfNeuronPopulation::addStimulus(uint cell, StochasticVariable *integrator, double weight, double revpot)
+{
+	VoltageDependance *integrand = new VoltageDependance(weight, revpot, "channel");
+	populationOwned.push_back(integrand);
+	populationStimulusCells.push_back(cell);
+	populationStimulusIntegrands.push_back(integrand);
+	populationStimulusIntegrators.push_back(integrator);
+	xTime->invalidateSchedule();
+	return populationStimulusCells.size() - 1;
+}
+
+int IfNeuronPopulation::addStimulus(uint cell, Synapse *synapse)
+{
+	TimeProcess *integrator = new TimeProcess(xTime);
+	populationOwned.push_back(integrator);
+	populationStimulusCells.push_back(cell);
+	populationStimulusIntegrands.push_back(synapse);
+	populationStimulusIntegrators.push_back(integrator);
+	xTime->invalidateSchedule();
+	return populationStimulusCells.size() - 1;
+}
+
+PopulationNeuron *IfNeuronPopulation::getNeuron(uint cell)
+{
+	if (cell >= populationSize) {
+		cout << "IfNeuronPopulation::getNeuron: cell " << cell << " out of range" << endl;
+		return 0;
+	}
+	if (!populationViews[cell])
+		populationViews[cell] = new PopulationNeuron(this, cell);
+	return populationViews[cell];
+}
+
+void IfNeuronPopulation::getDependencies( vector<TimeDependent *> &dependencies )
+{
+	dependencies.insert(dependencies.end(), populationInputs.begin(), populationInputs.end());
+	for (uint s=0; s<populationStimulusCells.size(); ++s) {
+		dependencies.push_back(populationStimulusIntegrands[s]);
+		dependencies.push_back(populationStimulusIntegrators[s]);
+	}
+}
+
+
+//____________________________________________________________________________
+//
+//  reset all cells
+//
+
+void IfNeuronPopulation::init()
+{
+	uint n = populationSize;
+	populationDecay.resize(n);
+	populationGain.resize(n);
+	populationNoiseScale.resize(n);
+	populationVoltage = populationReset;
+	populationVoltageNext = populationReset;
+	populationValue = populationReset;
+	populationValueNext = populationReset;
+	populationEvent.assign(n, 0);
+	populationEventNext.assign(n, 0);
+	populationRefractory.assign(n, 0.0);
+	populationConductance.assign(n, 0.0);
+	populationReversal.assign(n, 0.0);
+	populationConductanceInput.assign(n, 0.0);
+	populationReversalInput.assign(n, 0.0);
+	populationNoise.resize(n);
+	populationSpikes.clear();
+	populationSpikesNext.clear();
+	populationCoefficientsValid = false;
+	populationNextStateIsPrepared = false;
+}
+
+
+//____________________________________________________________________________
+//
+//  step all cells
+//
+
+void IfNeuronPopulation::prepareNextState()
+{
+	// single-cell stimuli need their integrators
+	for (uint s=0; s<populationStimulusIntegrators.size(); ++s)
+		if (!populationStimulusIntegrators[s]->isNextStatePrepared()) {
+			populationNextStateIsPrepared = false;
+			return;
+		}
+	
+	if (!populationCoefficientsValid)
+		updateCoefficients();
+	
+	uint n = populationSize;
+	if (n)
+		fillN(&populationNoise[0], n);
+	
+	// leak and drive exactly, synaptic current held over the step
+	const double *v = &populationVoltage[0];
+	const double *rest = &populationRest[0];
+	const double *decay = &populationDecay[0];
+	const double *gain = &populationGain[0];
+	const double *mean = &populationMean[0];
+	const double *scale = &populationNoiseScale[0];
+	const double *noise = &populationNoise[0];
+	const double *g = &populationConductance[0];
+	const double *gv = &populationReversal[0];
+	const double *gIn = &populationConductanceInput[0];
+	const double *gvIn = &populationReversalInput[0];
+	double *next = &populationVoltageNext[0];
+	for (uint i=0; i<n; ++i) {
+		double current = mean[i] + gv[i] + gvIn[i] - (g[i] + gIn[i]) * v[i];
+		next[i] = rest[i] + (v[i] - rest[i]) * decay[i] + gain[i] * current + scale[i] * noise[i];
+	}
+	
+	// single-cell stimuli, Ito
+	for (uint s=0; s<populationStimulusCells.size(); ++s) {
+		uint cell = populationStimulusCells[s];
+		next[cell] += (*populationStimulusIntegrands[s])(v[cell]) * populationStimulusIntegrators[s]->d();
+	}
+	
+	// refractory period, threshold and reset, with selects;
+	// as in IfNeuron a cell which spikes now stays at reset for the next step
+	const double *theta = &populationTheta[0];
+	const double *reset = &populationReset[0];
+	const char *spiking = &populationEvent[0];
+	double *refractory = &populationRefractory[0];
+	double *value = &populationValueNext[0];
+	char *event = &populationEventNext[0];
+	double height = populationSpikeHeight;
+	for (uint i=0; i<n; ++i) {
+		bool resting = spiking[i] || refractory[i] > 0.0;
+		bool spike = !resting && next[i] > theta[i];
+		next[i] = (resting || spike) ? reset[i] : next[i];
+		value[i] = spike ? height : next[i];
+		event[i] = spike;
+	}
+	
+	populationSpikesNext.clear();
+	for (uint i=0; i<n; ++i)
+		if (event[i])
+			populationSpikesNext.push_back(i);
+	
+	populationNextStateIsPrepared = true;
+}
+
+
+//____________________________________________________________________________
+//
+//  advance all cells
+//
+
+void IfNeuronPopulation::proceedToNextState()
+{
+	if (!populationNextStateIsPrepared)
+		return;
+	
+	populationVoltage.swap(populationVoltageNext);
+	populationValue.swap(populationValueNext);
+	populationEvent.swap(populationEventNext);
+	populationSpikes.swap(populationSpikesNext);
+	
+	// refractory clocks, spiking cells start theirs
+	uint n = populationSize;
+	double dt = xTime->dt;
+	double period = populationRefractoryPeriod;
+	double *refractory = &populationRefractory[0];
+	const char *event = &populationEvent[0];
+	for (uint i=0; i<n; ++i)
+		refractory[i] = event[i] ? period : max(refractory[i] - dt, 0.0);
+	
+	// conductances decay, including the ones added in this step
+	double decay = populationSynapticDecay;
+	double *g = &populationConductance[0];
+	double *gv = &populationReversal[0];
+	double *gIn = &populationConductanceInput[0];
+	double *gvIn = &populationReversalInput[0];
+	for (uint i=0; i<n; ++i) {
+		g[i] = (g[i] + gIn[i]) * decay;
+		gv[i] = (gv[i] + gvIn[i]) * decay;
+		gIn[i] = gvIn[i] = 0.0;
+	}
+	
+	populationNextStateIsPrepared = false;
+}
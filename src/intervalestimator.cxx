@@ -35,6 +35,7 @@ IntervalEstimator::IntervalEstimator(const Property& property, StochasticEventGe
 {
 	xTime = time;
 	nTime = -1;
+	dOffset = 0.0;
 	pEvent = event;
 }
 
@@ -45,8 +46,10 @@ void IntervalEstimator::collect()
 {
 	++nTime;     // quicker than nTime++
 	if( pEvent->hasEvent() ) {
-		estimate( xTime->dt * double(nTime) );
+		double offset = pEvent->getEventOffset();
+		estimate( xTime->dt * (double(nTime) + dOffset - offset) );
 		nTime = 0;
+		dOffset = offset;
 	}
 }
 
@@ -54,4 +57,5 @@ void IntervalEstimator::init()
 {
 	ScalarEstimator::init();
 	nTime = -1;
+	dOffset = 0.0;
 }
@@ -23,4 +23,70 @@ __________________________________________________________________________
 
 #include "../h/neuron.hxx"
 
+//____________________________________________________________________________
+//
+//  calibration of spiking neurons
+//
 
+void SpikingNeuron::calibrateThreshold(int isi, int spikes, int maxtime, double increment, double decrement, Time *time, ostream &log)
+{
+	const int batch = 5; // spikes between two sequential tests
+	if (!time)
+		time = xTime;
+	double target = isi * time->dt;
+	double stepsize, precision;
+	startCalibration(stepsize, precision);
+	double theta = getThreshold();
+	double start = stepsize;
+	int direction = 0; // current direction 1-up, -1-down
+	unsigned long long total = 0;
+	
+	// new interval estimator, measuring time in units
+	IntervalEstimator estimator(EST_MEAN|EST_VAR, this, time);
+	
+	NullStream devnull;
+	
+	int k=0;
+	for(; k<1000 && stepsize>=precision; k++) {
+		
+		// the sample only grows when the step size has become small
+		int budget = max(batch, min(spikes, int(batch * start / stepsize)));
+		
+		// sequential test of the fpt, stop when the target is clearly outside
+		double mean = 0.0;
+		int n = 0;
+		while (n < budget) {
+			time->run( batch, this, maxtime, devnull, n==0 );
+			n += batch;
+			mean = estimator.getEstimate(EST_MEAN).to_d();
+			if (mean == 0.0) {
+				mean = 1e23;
+				break;
+			}
+			// small samples of skewed intervals underestimate the spread, assume at least that of a Poisson train
+			double error = max(sqrt(estimator.getEstimate(EST_VAR).to_d()), target) / sqrt(double(n));
+			if (fabs(mean - target) > 2.0 * error)
+				break;
+		}
+		total += n;
+		
+		// keep direction and increase step size, or turn and decrease it
+		int wanted = (mean < target) ? 1 : -1;
+		if (direction == wanted)
+			stepsize *= increment;
+		else if (direction != 0)
+			stepsize *= decrement;
+		direction = wanted;
+		
+		// note to the user
+		log << "\rthreshold: " << theta << ", spike rate: " << 1.0/mean << " Hz, target rate: " << 1.0/target << " Hz, next correction: " << direction*stepsize << "\t\t\t" << flush;
+		
+		// apply correction
+		theta += direction * stepsize;
+		setThreshold(theta);
+	}
+	
+	log << "\ncalibrated neuron after " << k << " steps and " << total << " spikes.\t\t\t\t\t" << endl;
+	
+	init();
+}
@@ -28,11 +28,6 @@ __________________________________________________________________________
 // Inverse error function.
 double erfinv(double target)
 {
-	double stepsize = 0.4; // starting stepsize
-	double source = 0.0;
-	int direction = 1; // current direction 1-up, -1-down
-	double error = 0.000000001;
-	
 	if( target > 1.0 || target < -1.0 ) {
 		cout << "argument for erfinv outside of domain" << endl;
 		return 0.0; // I mean NaN
@@ -41,41 +36,50 @@ double erfinv(double target)
 	if( target==1.0 ) return 1e24; // replacement for inf
 	if( target==-1.0 ) return -1e24; // replacement for -inf
 	
-	int k;
-	for( k=0; k<1000000; k++) {
-		double current = erf( source );
-		
-		if(current > target) {
-			if(direction == 1) {
-				// too large and direction up - decrease stepsize and turn
-				stepsize *= 0.6;
-				direction *= -1;
-			} else
-				// too large and direction down - increase stepsize
-				stepsize *= 1.1;
-		} else {
-			if(direction == -1) {
-				// too small and direction down - decrease stepsize and turn
-				stepsize *= 0.6;
-				direction *= -1;
-			} else
-				// too small and direction up - increase stepsize
-				stepsize *= 1.1;
+	// Giles' approximation, single precision
+	double w = -log((1.0 - target) * (1.0 + target));
+	double p;
+	if( w < 5.0 ) {
+		w -= 2.5;
+		p = 2.81022636e-08;
+		p = 3.43273939e-07 + p*w;
+		p = -3.5233877e-06 + p*w;
+		p = -4.39150654e-06 + p*w;
+		p = 0.00021858087 + p*w;
+		p = -0.00125372503 + p*w;
+		p = -0.00417768164 + p*w;
+		p = 0.246640727 + p*w;
+		p = 1.50140941 + p*w;
+	} else {
+		w = sqrt(w) - 3.0;
+		p = -0.000200214257;
+		p = 0.000100950558 + p*w;
+		p = 0.00134934322 + p*w;
+		p = -0.00367342844 + p*w;
+		p = 0.00573950773 + p*w;
+		p = -0.0076224613 + p*w;
+		p = 0.00943887047 + p*w;
+		p = 1.00167406 + p*w;
+		p = 2.83297682 + p*w;
+	}
+	double source = p * fabs(target);
+	
+	// Newton polish, in the tails on the logarithm of the complement, which is almost linear in source^2
+	double y = fabs(target);
+	for( int k=0; k<8; ++k ) {
+		double step;
+		if( y < 0.5 )
+			step = (erf(source) - y) / (1.1283791670955126 * exp(-source*source));
+		else {
+			double tail = erfc(source);
+			step = -log(tail / (1.0 - y)) * tail / (1.1283791670955126 * exp(-source*source));
 		}
-		source += direction * stepsize;
-		
-		// early stopping
-		if( stepsize < error )
+		source -= step;
+		if( fabs(step) <= 1e-15 * source )
 			break;
 	}
-/*	// note
-	cout << "erfinv(" << target 
-		<< ") = " << source 
-		<< ", stepsize = " << stepsize 
-		<< ", " << k << " steps, "
-		<< " error = " << erf(source) - target << endl;
-*/	
-	return source;
+	
+	return target < 0.0 ? -source : source;
 }
 
 
@@ -101,6 +105,14 @@ Noise::Noise( const Noise &noise)
 	: StochasticVariable(noise.xTime)
 {}
 
+//__________________________________________________________________________
+//   Dependencies.
+void Noise::getDependencies( vector<TimeDependent *> &dependencies )
+{
+	if (pParent)
+		dependencies.push_back( pParent );
+}
+
 //__________________________________________________________________________
 //   Destruct.
 Noise::~Noise()
@@ -321,6 +333,138 @@ void WienerNoise::setNext(double omega)
 
 
 
+//////////////////////////////////////////////////
+//   Ornstein-Uhlenbeck Noise Source
+//////////////////////////////////////////////////
+
+//__________________________________________________________________________
+//   construct
+
+OUNoise::OUNoise(NoiseSource *parent, int index, const string& name, const string& type)
+	: Noise(parent, index, name, type)
+{
+	ouTau = 1.0;
+	ouCurrent = noiseMu;
+	ouStarted = false;
+	addParameter("tau");
+	setCoefficients();
+}
+
+OUNoise::OUNoise( const OUNoise &noise )
+	: Noise( noise )
+{}
+	
+//__________________________________________________________________________
+//   destruct
+
+OUNoise::~OUNoise()
+{}
+
+//__________________________________________________________________________
+//   set/get parameters
+
+Noise &OUNoise::setTau( double tau )
+{
+	ouTau = tau;
+	setCoefficients();
+
+	return *this;
+}
+
+Noise &OUNoise::setRate( double rate )
+{
+	Noise::setRate(rate);
+	setCoefficients();
+
+	return *this;
+}
+
+Noise &OUNoise::setWeight( double weight )
+{
+	Noise::setWeight(weight);
+	setCoefficients();
+
+	return *this;
+}
+
+Noise &OUNoise::setMean( double mu )
+{
+	Noise::setMean(mu);
+	setCoefficients();
+
+	return *this;
+}
+
+Noise &OUNoise::setStdDev( double sigma )
+{
+	Noise::setStdDev(sigma);
+	setCoefficients();
+
+	return *this;
+}
+
+void OUNoise::setParameter( const string& name, const string& value )
+{
+	if (name == "tau") {
+		stringstream param;
+		double d;
+		param << value;
+		param >> d;
+		setTau(d);
+	}
+	else
+		Noise::setParameter(name, value);
+}
+
+string OUNoise::getParameter( const string& name ) const
+{
+	stringstream param;
+	if (name == "tau")
+		param << ouTau;
+	else
+		param << Noise::getParameter(name);
+		
+	return param.str();
+}
+
+void OUNoise::setCoefficients()
+{
+	ouDecay = exp(-xTime->dt / ouTau);
+	ouSpread = noiseSigma / sqrt(2.0 * ouTau);
+	ouScale = ouSpread * sqrt(1.0 - ouDecay * ouDecay);
+}
+
+//__________________________________________________________________________
+//   initialise
+
+void OUNoise::init()
+{
+	Noise::init();
+	ouCurrent = noiseMu;
+	ouStarted = false;
+}
+
+//__________________________________________________________________________
+//   calculate next value
+
+void OUNoise::setNext(double omega)
+{
+	stochCurrentValue = stochNextValue;
+	if (!ouStarted) {
+		// stationary start
+		ouCurrent = noiseMu + ouSpread * omega;
+		ouStarted = true;
+		stochNextValue += ouCurrent * xTime->dt;
+		return;
+	}
+	
+	// exact step of the current, trapezoidal step of the integral
+	double current = noiseMu + ouDecay * (ouCurrent - noiseMu) + ouScale * omega;
+	stochNextValue += 0.5 * (ouCurrent + current) * xTime->dt;
+	ouCurrent = current;
+}
+
+
 //////////////////////////////////////////////////
 //   NoiseSource
 //////////////////////////////////////////////////
@@ -328,37 +472,17 @@ void WienerNoise::setNext(double omega)
 //////////////////////////////////////////////////
 // Construct.
 NoiseSource::NoiseSource( Time *time,  int n )
-	: StochasticProcess(time)
+	: StochasticProcess(time), RandN(time)
 {
-	nNoises = n;
-	
-	// noise array
-	aNoises = new Noise *[nNoises];
-	for(int i=0; i<n; i++)
-		aNoises[i] = 0;
-	
-	// mixing array
-	aA = new double *[nNoises];
-	for(int i=0; i<n; i++) {
-		aA[i] = new double[nNoises];
-		for(int j=0; j<nNoises; j++)
-			if (i==j)
-				aA[i][j] = 1.0 / sqrt( double(nNoises) );
-			else
-				aA[i][j] = 0.0;
-	}
-	
-	// omega array
-	aOmega = new double[nNoises];
-	for(int i=0; i<n; i++)
-		aOmega[i] = dRandN();	
+	allocate(n);
 }
 
 //////////////////////////////////////////////////
 // Construct.
 NoiseSource::NoiseSource(Time *time, Matrix a )
-	: StochasticProcess(time)
+	: StochasticProcess(time), RandN(time)
 {
+	allocate(a.nSize(0));
 	setMixingMatrix(a);
 }
 
@@ -371,53 +495,305 @@ NoiseSource::~NoiseSource()
 		if(aNoises[i])
 			delete aNoises[i];
 	delete[] aNoises;
+}
+
+//////////////////////////////////////////////////
+//   Allocate arrays.
+void NoiseSource::allocate( int n )
+{
+	nNoises = n;
 	
-	// mixing array
-	for(int i=0; i<nNoises; i++)
-		delete[] aA[i];
-	delete[] aA;
+	// noise array
+	aNoises = new Noise *[nNoises];
+	for(int i=0; i<n; i++)
+		aNoises[i] = 0;
+	
+	// mixing array, a diagonal matrix is sparse
+	nMixing = MIXING_SPARSE;
+	nRank = 0;
+	aA.assign(nNoises, 1.0 / sqrt( double(nNoises) ));
+	aColumns.resize(nNoises);
+	aRows.resize(nNoises + 1);
+	for(int i=0; i<=n; i++) {
+		aRows[i] = i;
+		if (i < n)
+			aColumns[i] = i;
+	}
 	
 	// omega array
-	delete[] aOmega;
+	aOmega.resize(nNoises);
+	aIndicators.resize(nNoises);
+	fillN(&aOmega[0], nNoises);
+	
+	aVariances.resize(nNoises);
+	reconfigure();
 }
 
 //////////////////////////////////////////////////
-//   Set the mixing matrix.
-void NoiseSource::setMixingMatrix( Matrix a )
+//   Read a matrix.
+bool NoiseSource::readMatrix( Matrix &a, int columns, vector<double> &values, const char *caller )
 {
 	if(a.nDimension() != 2) {
-		cout << "NoiseSource::setMixingMatrix(Matrix): Matrix has " 
+		cout << "NoiseSource::" << caller << "(Matrix): Matrix has " 
 			<< a.nDimension() 
 			<< " dimension(s), instead of two." << endl;
-		return;
+		return false;
 	}
 	if(a.nSize(0) != nNoises)  {
-		cout << "NoiseSource::setMixingMatrix(Matrix): Matrix' first dimension has size of " 
+		cout << "NoiseSource::" << caller << "(Matrix): Matrix' first dimension has size of " 
 			<< a.nSize(0) 
 			<< " instead of " 
 			<< nNoises << endl;
-		return;
+		return false;
 	}
-	if(a.nSize(1) != nNoises)  {
-		cout << "NoiseSource::setMixingMatrix(Matrix): Matrix' first dimension has size of " 
+	if(columns >= 0 && a.nSize(1) != columns)  {
+		cout << "NoiseSource::" << caller << "(Matrix): Matrix' second dimension has size of " 
 			<< a.nSize(1) 
 			<< " instead of " 
+			<< columns << endl;
+		return false;
+	}
+	
+	// row by row
+	columns = a.nSize(1);
+	values.resize(nNoises * columns);
+	for(int i=0; i<nNoises; ++i)
+		for(int j=0; j<columns; ++j)
+			values[i*columns + j] = a[i][j].to_d();
+	return true;
+}
+
+//////////////////////////////////////////////////
+//   Set the mixing matrix.
+void NoiseSource::setMixingMatrix( Matrix a )
+{
+	vector<double> values;
+	if (!readMatrix(a, nNoises, values, "setMixingMatrix"))
+		return;
+	
+	// find the structure
+	int n = nNoises, nonzero = 0;
+	bool lower = true;
+	for(int i=0; i<n; ++i)
+		for(int j=0; j<n; ++j)
+			if (values[i*n + j] != 0.0) {
+				++nonzero;
+				if (j > i)
+					lower = false;
+			}
+	nRank = 0;
+	aOmega.resize(nNoises);
+	
+	if (4*nonzero <= n*n) {
+		vector<uint> rows, columns;
+		vector<double> entries;
+		for(int i=0; i<n; ++i)
+			for(int j=0; j<n; ++j)
+				if (values[i*n + j] != 0.0) {
+					rows.push_back(i);
+					columns.push_back(j);
+					entries.push_back(values[i*n + j]);
+				}
+		setMixingMatrix(rows, columns, entries);
+		return;
+	}
+	
+	// by columns, each column of a lower triangle starts at the diagonal
+	aA.clear();
+	for(int j=0; j<n; ++j)
+		for(int i=(lower ? j : 0); i<n; ++i)
+			aA.push_back(values[i*n + j]);
+	nMixing = lower ? MIXING_LOWER : MIXING_DENSE;
+	reconfigure();
+}
+
+//////////////////////////////////////////////////
+//   Set a sparse mixing matrix.
+void NoiseSource::setMixingMatrix( const vector<uint> &rows, const vector<uint> &columns, const vector<double> &values )
+{
+	uint entries = values.size();
+	if (rows.size() != entries || columns.size() != entries) {
+		cout << "NoiseSource::setMixingMatrix(rows, columns, values): lists have different sizes." << endl;
+		return;
+	}
+	for (uint k=0; k<entries; ++k)
+		if (rows[k] >= uint(nNoises) || columns[k] >= uint(nNoises)) {
+			cout << "NoiseSource::setMixingMatrix(rows, columns, values): entry (" << rows[k] << ", " << columns[k] << ") outside of the matrix." << endl;
+			return;
+		}
+	
+	// counting sort into rows
+	aRows.assign(nNoises + 1, 0);
+	for (uint k=0; k<entries; ++k)
+		++aRows[rows[k] + 1];
+	for (int i=0; i<nNoises; ++i)
+		aRows[i + 1] += aRows[i];
+	vector<uint> next(aRows.begin(), aRows.end() - 1);
+	aColumns.resize(entries);
+	aA.resize(entries);
+	for (uint k=0; k<entries; ++k) {
+		uint e = next[rows[k]]++;
+		aColumns[e] = columns[k];
+		aA[e] = values[k];
+	}
+	
+	nRank = 0;
+	aOmega.resize(nNoises);
+	nMixing = MIXING_SPARSE;
+	reconfigure();
+}
+
+//////////////////////////////////////////////////
+//   Set shared factors and private noise.
+void NoiseSource::setMixingFactors( Matrix factors, const vector<double> &diagonal )
+{
+	vector<double> values;
+	if (!readMatrix(factors, -1, values, "setMixingFactors"))
+		return;
+	if (diagonal.size() != uint(nNoises)) {
+		cout << "NoiseSource::setMixingFactors(Matrix, diagonal): diagonal has size of " 
+			<< diagonal.size() 
+			<< " instead of " 
 			<< nNoises << endl;
 		return;
 	}
+	
+	// factors by columns
+	int k = factors.nSize(1);
+	aA.resize(nNoises * k);
 	for(int i=0; i<nNoises; ++i)
-		for(int j=0; j<nNoises; ++j)
-			aA[i][j] = a[i][j].to_d();
+		for(int j=0; j<k; ++j)
+			aA[j*nNoises + i] = values[i*k + j];
+	aDiagonal = diagonal;
+	
+	nRank = k;
+	aOmega.resize(nNoises + nRank);
+	fillN(&aOmega[0], nNoises + nRank);
+	nMixing = MIXING_LOW_RANK;
+	reconfigure();
+}
+
+//////////////////////////////////////////////////
+//   Set the covariance matrix.
+void NoiseSource::setCovarianceMatrix( Matrix c )
+{
+	vector<double> values;
+	if (!readMatrix(c, nNoises, values, "setCovarianceMatrix"))
+		return;
+	
+	// Cholesky-Banachiewicz, row by row
+	int n = nNoises;
+	vector<double> lower(n*n, 0.0);
+	for(int i=0; i<n; ++i)
+		for(int j=0; j<=i; ++j) {
+			double sum = values[i*n + j];
+			for(int k=0; k<j; ++k)
+				sum -= lower[i*n + k] * lower[j*n + k];
+			if (i == j) {
+				if (sum <= 0.0) {
+					cout << "NoiseSource::setCovarianceMatrix(Matrix): Matrix is not positive definite." << endl;
+					return;
+				}
+				lower[i*n + i] = sqrt(sum);
+			}
+			else
+				lower[i*n + j] = sum / lower[j*n + j];
+		}
+	
+	// by columns, each column starts at the diagonal
+	aA.clear();
+	for(int j=0; j<n; ++j)
+		for(int i=j; i<n; ++i)
+			aA.push_back(lower[i*n + j]);
+	nRank = 0;
+	aOmega.resize(nNoises);
+	nMixing = MIXING_LOWER;
+	reconfigure();
+}
+
+//////////////////////////////////////////////////
+//   Get indicator covariance.
+double NoiseSource::getIndicatorCovariance( int n, int m )
+{
+	double c = 0.0;
+	int size = nNoises;
+	switch (nMixing) {
+	case MIXING_DENSE:
+		for(int j=0; j<size; ++j)
+			c += aA[j*size + n] * aA[j*size + m];
+		break;
+	case MIXING_LOWER:
+		for(int j=0, start=0; j<=n && j<=m; start += size - j, ++j)
+			c += aA[start + n - j] * aA[start + m - j];
+		break;
+	case MIXING_LOW_RANK:
+		for(int j=0; j<nRank; ++j)
+			c += aA[j*size + n] * aA[j*size + m];
+		if (n == m)
+			c += aDiagonal[n] * aDiagonal[n];
+		break;
+	case MIXING_SPARSE:
+		for(uint k=aRows[n]; k<aRows[n + 1]; ++k)
+			for(uint l=aRows[m]; l<aRows[m + 1]; ++l)
+				if (aColumns[k] == aColumns[l])
+					c += aA[k] * aA[l];
+		break;
+	}
+	return c;
 }
 	
 //////////////////////////////////////////////////
 //   Get indicator variance.
 double NoiseSource::getIndicatorVariance( int n )
 {
-	double var = 0;
-	for(int i=0; i<nNoises; ++i)
-		var += aA[n][i] * aA[n][i];
-	return var;
+	return aVariances[n];
+}
+
+//////////////////////////////////////////////////
+//   Recompute variances and thresholds.
+void NoiseSource::reconfigure()
+{
+	int n = nNoises;
+	double *variances = &aVariances[0];
+	const double *a = aA.empty() ? 0 : &aA[0];
+	
+	// squared entries, column by column like mix()
+	switch (nMixing) {
+	case MIXING_DENSE:
+		for(int i=0; i<n; ++i)
+			variances[i] = 0.0;
+		for(int j=0; j<n; ++j, a += n)
+			for(int i=0; i<n; ++i)
+				variances[i] += a[i] * a[i];
+		break;
+	case MIXING_LOWER:
+		for(int i=0; i<n; ++i)
+			variances[i] = 0.0;
+		for(int j=0; j<n; a += n - j, ++j)
+			for(int i=0; i<n-j; ++i)
+				variances[i + j] += a[i] * a[i];
+		break;
+	case MIXING_LOW_RANK:
+		for(int i=0; i<n; ++i)
+			variances[i] = aDiagonal[i] * aDiagonal[i];
+		for(int j=0; j<nRank; ++j, a += n)
+			for(int i=0; i<n; ++i)
+				variances[i] += a[i] * a[i];
+		break;
+	case MIXING_SPARSE:
+		for(int i=0; i<n; ++i) {
+			double sum = 0.0;
+			for(uint k=aRows[i]; k<aRows[i + 1]; ++k)
+				sum += aA[k] * aA[k];
+			variances[i] = sum;
+		}
+		break;
+	}
+	
+	// thresholds
+	for(int i=0; i<n; ++i)
+		if(aNoises[i])
+			aNoises[i]->reconfigure();
 }
 	
 //////////////////////////////////////////////////
@@ -425,20 +801,18 @@ double NoiseSource::getIndicatorVariance( int n )
 double NoiseSource::getCovariationCoeff( int n, int m )
 {
 	// correlation factor
-	double c_nm = 0.0;
-	for(int i=0; i<nNoises; ++i)
-		c_nm += aA[n][i] * aA[m][i];
+	double c_nm = getIndicatorCovariance(n, m);
 	
 	// correction offset for large time steps
 	double stepCorrection = xTime->dt * aNoises[n]->getMean() * aNoises[m]->getMean();
 	stepCorrection = 0.0;
 
 	// two wiener noises: sigma_n * sigma_m * c_nm
-	if (aNoises[n]->getType()=="correlated_wiener_process" && aNoises[m]->getType()=="correlated_wiener_process")
+	if (aNoises[n]->getType()=="Correlated Wiener Process" && aNoises[m]->getType()=="Correlated Wiener Process")
 		return stepCorrection + c_nm * aNoises[n]->getStdDev() * aNoises[m]->getStdDev();
 
 	// wiener and poisson: sigma_n * (w_m * rate_m * s_m) * c_nm
-	if (aNoises[n]->getType()=="correlated_wiener_process" && aNoises[m]->getType()=="correlated_poisson_process") {
+	if (aNoises[n]->getType()=="Correlated Wiener Process" && aNoises[m]->getType()=="Correlated Poisson Process") {
 		double var = getIndicatorVariance(m);
 		double pi = 3.141592653589793115997963468544185161590576171875;
 		double theta = ((PoissonNoise*)aNoises[m])->getThreshold() / sqrt(2.0 * var);
@@ -451,10 +825,10 @@ double NoiseSource::getCovariationCoeff( int n, int m )
 	}
 	
 	// poisson and wiener: (w_n * rate_n * s_n) * sigma_m * c_nm
-	if (aNoises[n]->getType()=="correlated_poisson_process" && aNoises[m]->getType()=="correlated_wiener_process") {
+	if (aNoises[n]->getType()=="Correlated Poisson Process" && aNoises[m]->getType()=="Correlated Wiener Process") {
 		double var = getIndicatorVariance(n);
 		double pi = 3.141592653589793115997963468544185161590576171875;
-		double theta = ((PoissonNoise*)aNoises[m])->getThreshold();
+		double theta = ((PoissonNoise*)aNoises[n])->getThreshold();
 		theta /= sqrt(2.0 * var);
 		double cndSum = sqrt(2.0*var/pi); // conditional sum: < x | x>theta >
 		cndSum *= exp(- theta*theta);
@@ -465,7 +839,7 @@ double NoiseSource::getCovariationCoeff( int n, int m )
 	}
 	
 	// poisson and poisson: (w_n * rate_n) * (w_m * rate_m) * c_nm
-	if (aNoises[n]->getType()=="correlated_poisson_process" && aNoises[m]->getType()=="correlated_poisson_process") {
+	if (aNoises[n]->getType()=="Correlated Poisson Process" && aNoises[m]->getType()=="Correlated Poisson Process") {
 		if (n==m)
 			return aNoises[n]->getWeight() * aNoises[m]->getWeight() * aNoises[n]->getRate();
 		else
@@ -497,9 +871,8 @@ Noise *NoiseSource::createNoise( int n, const string &type )
 			aNoises[n] = new PoissonNoise(this, n, name.str());
 		}
 		else if (type=="Correlated Ornstein-Uhlenbeck Process") {
-			cout << "Ornstein-Uhlenbeck process not implemented yet." << endl;
-			name << "Wiener process" << "[" << n << "]" << flush;
-			aNoises[n] = new WienerNoise(this, n, name.str());
+			name << "Ornstein-Uhlenbeck process" << "[" << n << "]" << flush;
+			aNoises[n] = new OUNoise(this, n, name.str());
 		}
 		if( aNoises[n] )
 			aNoises[n]->setDescription(name.str());
@@ -529,27 +902,71 @@ void NoiseSource::destructionNotify( int n )
 //   next indicator values
 void NoiseSource::prepareNextState()
 {
-	for(int i=0; i<nNoises; ++i)
-		aOmega[i] = dRandN();
+	fillN(&aOmega[0], aOmega.size());
 	stochNextStateIsPrepared = true;
 }
 
 //////////////////////////////////////////////////
-//   proceed all noises
-void NoiseSource::proceedToNextState()
+//   mix indicators
+void NoiseSource::mix()
 {
-	stochNextStateIsPrepared = false;
-	for(int i=0; i<nNoises; ++i) {
-		if(aNoises[i]) {
-			double omega = 0.0;
-			
-			// sum up next value
-			for(int n=0; n<nNoises; ++n)
-				omega += aA[i][n] * aOmega[n];
-			
-			// notify noise process
-			aNoises[i]->setNext(omega);
+	int n = nNoises;
+	double *indicators = &aIndicators[0];
+	const double *omega = &aOmega[0];
+	const double *a = aA.empty() ? 0 : &aA[0];
+	
+	// column by column, each column is one contiguous, vectorisable update
+	switch (nMixing) {
+	case MIXING_DENSE:
+		for(int i=0; i<n; ++i)
+			indicators[i] = 0.0;
+		for(int j=0; j<n; ++j, a += n) {
+			double w = omega[j];
+			for(int i=0; i<n; ++i)
+				indicators[i] += a[i] * w;
+		}
+		break;
+	case MIXING_LOWER:
+		for(int i=0; i<n; ++i)
+			indicators[i] = 0.0;
+		for(int j=0; j<n; a += n - j, ++j) {
+			double w = omega[j];
+			for(int i=0; i<n-j; ++i)
+				indicators[i + j] += a[i] * w;
 		}
+		break;
+	case MIXING_LOW_RANK: {
+		const double *diagonal = &aDiagonal[0];
+		const double *shared = omega + n;
+		for(int i=0; i<n; ++i)
+			indicators[i] = diagonal[i] * omega[i];
+		for(int j=0; j<nRank; ++j, a += n) {
+			double w = shared[j];
+			for(int i=0; i<n; ++i)
+				indicators[i] += a[i] * w;
+		}
+		break;
+	}
+	case MIXING_SPARSE:
+		for(int i=0; i<n; ++i) {
+			double sum = 0.0;
+			for(uint k=aRows[i]; k<aRows[i + 1]; ++k)
+				sum += aA[k] * omega[aColumns[k]];
+			indicators[i] = sum;
+		}
+		break;
 	}
+}
+
+//////////////////////////////////////////////////
+//   proceed all noises
+void NoiseSource::proceedToNextState()
+{
 	stochNextStateIsPrepared = false;
+	mix();
+	
+	// notify noise processes
+	for(int i=0; i<nNoises; ++i)
+		if(aNoises[i])
+			aNoises[i]->setNext(aIndicators[i]);
 }
@@ -0,0 +1,165 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#include "../h/poissonpopulationinput.hxx"
+
+#include <sstream>
+
+//____________________________________________________________________________
+//
+//  Construction
+//
+
+PoissonPopulationInput::PoissonPopulationInput( Time *time, double w, double n, double lambda, double n_rc, double lambda_rc, const string& name, const string& type )
+	: RandN( time ), StochasticVariable( time, name, type )
+{
+	populationW = w;
+	populationN = n;
+	populationLambda = lambda;
+	populationCoincWidth = n_rc;
+	populationCoincRate = lambda_rc;
+	populationWeightDev = 0.0;
+	populationDelta = 0.0;
+	stochDescription = "summed Poisson processes";
+	addParameter("number-of-processes");
+	addParameter("single-weight");
+	addParameter("single-rate");
+	addParameter("coincidence-width");
+	addParameter("coincidence-rate");
+	addParameter("weight-deviation");
+	init();
+}
+
+PoissonPopulationInput::~PoissonPopulationInput() {}
+
+// set event rates
+void PoissonPopulationInput::updateRates()
+{
+	double dt = xTime->dt;
+	double coincidence = populationCoincWidth * populationCoincRate;
+	populationSingleMean = populationN * populationLambda * (1.0 - coincidence) * dt;
+	populationCoincMean = populationCoincRate * populationLambda * dt;
+	populationCoincWeight = populationN * populationCoincWidth * populationW;
+	
+	if (coincidence > 1.0)
+		cout << "PoissonPopulationInput: coincidences take up more than all events." << endl;
+}
+
+void PoissonPopulationInput::init()
+{
+	updateRates();
+	populationDelta = 0.0;
+	StochasticVariable::init();
+}
+
+//____________________________________________________________________________
+//
+//  Simulation
+//
+
+void PoissonPopulationInput::prepareNextState()
+{
+	if (stochNextStateIsPrepared)
+		return;
+	
+	// single events
+	uint singles = nRandP(populationSingleMean);
+	double delta = singles * populationW;
+	if (singles && populationWeightDev > 0.0)
+		delta += populationWeightDev * sqrt(double(singles)) * dRandN();
+	
+	// coincident events
+	if (populationCoincMean > 0.0)
+		delta += nRandP(populationCoincMean) * populationCoincWeight;
+	
+	populationDelta = delta;
+	stochNextValue = stochCurrentValue + delta;
+	stochNextStateIsPrepared = true;
+}
+
+//____________________________________________________________________________
+//
+//  Parameters
+//
+
+void PoissonPopulationInput::setWeightDeviation( double deviation )
+{
+	populationWeightDev = deviation;
+}
+
+double PoissonPopulationInput::getMean()
+{
+	return populationN * populationW * populationLambda;
+}
+
+double PoissonPopulationInput::getVariance()
+{
+	double square = populationW * populationW + populationWeightDev * populationWeightDev;
+	return (populationSingleMean * square + populationCoincMean * populationCoincWeight * populationCoincWeight) / xTime->dt;
+}
+
+string PoissonPopulationInput::getParameter(const string& name) const
+{
+	stringstream param;
+		
+	if (name == "single-weight")
+		param << populationW;
+	else if (name == "number-of-processes")
+		param << populationN;
+	else if (name == "single-rate")
+		param << populationLambda;
+	else if (name == "coincidence-width")
+		param << populationCoincWidth;
+	else if (name == "coincidence-rate")
+		param << populationCoincRate;
+	else if (name == "weight-deviation")
+		param << populationWeightDev;
+	else
+		param << StochasticVariable::getParameter( name );
+
+	return param.str();
+}
+
+void PoissonPopulationInput::setParameter(const string& name, const string& value)
+{
+	stringstream param;
+	param << value;
+		
+	if (name == "single-weight")
+		param >> populationW;
+	else if (name == "number-of-processes")
+		param >> populationN;
+	else if (name == "single-rate")
+		param >> populationLambda;
+	else if (name == "coincidence-width")
+		param >> populationCoincWidth;
+	else if (name == "coincidence-rate")
+		param >> populationCoincRate;
+	else if (name == "weight-deviation")
+		param >> populationWeightDev;
+	else {
+		StochasticVariable::setParameter( name, value );
+		return;
+	}
+	updateRates();
+}
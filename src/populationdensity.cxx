@@ -0,0 +1,499 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#include "../h/populationdensity.hxx"
+#include "../h/ifneuron.hxx"
+#include "../h/thetaneuron.hxx"
+#include "../h/synapse.hxx"
+#include "../h/aggregateconductance.hxx"
+#include "../h/graph.hxx"
+#include "../h/wiener.hxx"
+#include "../h/processes.hxx"
+#include <math.h>
+
+//____________________________________________________________________________
+//
+//  helpers
+//
+
+// Bernoulli function z/(exp(z)-1) of the Scharfetter-Gummel flux
+static double bernoulli( double z )
+{
+	if (fabs(z) < 1e-8)
+		return 1.0 - 0.5*z;
+	return z / expm1(z);
+}
+
+// rates of the flux p_l*up - p_r*down between two points at the given distance
+static void faceRates( double drift, double diffusion, double distance, double &up, double &down )
+{
+	if (diffusion > 0.0) {
+		double peclet = drift * distance / diffusion;
+		up = diffusion / distance * bernoulli(-peclet);
+		down = diffusion / distance * bernoulli(peclet);
+	}
+	else {
+		// pure drift, upwind
+		up = drift > 0.0 ? drift : 0.0;
+		down = drift < 0.0 ? -drift : 0.0;
+	}
+}
+
+
+//____________________________________________________________________________
+//
+//  construct
+//
+
+PopulationDensity::PopulationDensity(IfNeuron *neuron, uint cells)
+{
+	densityEquation = &neuron->ifneuronMembrane;
+	densityCells = cells;
+	densityThreshold = neuron->ifneuronTheta;
+	densityReset = densityEquation->getStartingValue();
+	densityBins = 100;
+	densityRange[0] = densityRange[1] = 0.0;
+	compile();
+	
+	// below the reset or the resting point by six standard deviations of the free membrane
+	double span = densityThreshold - densityReset;
+	double drift, diffusion, driftAbove, driftBelow;
+	getCoefficients(densityReset, drift, diffusion);
+	getCoefficients(densityReset + 1e-3*span, driftAbove, diffusion);
+	getCoefficients(densityReset - 1e-3*span, driftBelow, diffusion);
+	double slope = (driftAbove - driftBelow) / (2e-3*span);
+	densityLower = densityReset - span;
+	if (slope < 0.0) {
+		double rest = densityReset - drift / slope;
+		getCoefficients(rest, drift, diffusion);
+		densityLower = min(densityReset, rest) - 6.0 * sqrt(diffusion / -slope);
+		densityLower = min(densityLower, densityReset - 0.1*span);
+	}
+
+	// widen the cells slightly so that the reset is at the centre of one
+	if (densityReset > densityLower) {
+		double above = floor((densityThreshold - densityReset) * cells / (densityThreshold - densityLower) - 0.5);
+		if (above >= 0.0 && above + 1.0 < cells)
+			densityLower = densityThreshold - cells * (densityThreshold - densityReset) / (above + 0.5);
+	}
+	build();
+}
+
+PopulationDensity::PopulationDensity(ThetaNeuron *neuron, uint cells)
+{
+	densityEquation = &neuron->thetaMembrane;
+	densityCells = cells;
+	densityLower = -M_PI;
+	densityThreshold = M_PI;
+	densityReset = -M_PI;
+	densityBins = 100;
+	densityRange[0] = densityRange[1] = 0.0;
+	update();
+}
+
+PopulationDensity::PopulationDensity(DifferentialEquation *equation, double lower, double threshold, double reset, uint cells)
+{
+	densityEquation = equation;
+	densityCells = cells;
+	densityLower = lower;
+	densityThreshold = threshold;
+	densityReset = reset;
+	densityBins = 100;
+	densityRange[0] = densityRange[1] = 0.0;
+	update();
+}
+
+void PopulationDensity::update()
+{
+	compile();
+	build();
+}
+
+
+//____________________________________________________________________________
+//
+//  read the terms
+//
+
+void PopulationDensity::compile()
+{
+	densityDt = densityEquation->getTime()->dt;
+	densityStratonovich = densityEquation->isStratonovich();
+	densityIntegrands.clear();
+	densityDrifts.clear();
+	densityVariances.clear();
+	
+	for (int i=0; i<densityEquation->getNTerms(); ++i) {
+		StochasticFunction *integrand = densityEquation->getIntegrand(i);
+		StochasticVariable *integrator = densityEquation->getIntegrator(i);
+		if (dynamic_cast<Synapse *>(integrand) || dynamic_cast<AggregateConductance *>(integrand)) {
+			cout << "population density: integrand " << integrand->getName() << " (" << integrand->getType() << ") depends on other processes, term " << i << " is ignored" << endl;
+			continue;
+		}
+		
+		Wiener *wiener = dynamic_cast<Wiener *>(integrator);
+		if (dynamic_cast<TimeProcess *>(integrator)) {
+			densityIntegrands.push_back(integrand);
+			densityDrifts.push_back(1.0);
+			densityVariances.push_back(0.0);
+		}
+		else if (wiener) {
+			densityIntegrands.push_back(integrand);
+			densityDrifts.push_back(wiener->getMean() / integrator->getTime()->dt);
+			densityVariances.push_back(wiener->getVariance());
+		}
+		else
+			cout << "population density: integrator " << integrator->getName() << " (" << integrator->getType() << ") is neither time nor Wiener process, term " << i << " is ignored" << endl;
+	}
+}
+
+void PopulationDensity::getCoefficients( double x, double &drift, double &diffusion )
+{
+	drift = diffusion = 0.0;
+	for (uint i=0; i<densityIntegrands.size(); ++i) {
+		double f = (*densityIntegrands[i])(x);
+		drift += f * densityDrifts[i];
+		diffusion += 0.5 * f * f * densityVariances[i];
+		if (densityStratonovich && densityVariances[i] > 0.0)
+			drift += 0.5 * f * densityIntegrands[i]->getDerivative(x) * densityVariances[i];
+	}
+}
+
+
+//____________________________________________________________________________
+//
+//  build the operator and the stationary state
+//
+
+void PopulationDensity::build()
+{
+	uint n = densityCells;
+	double h = (densityThreshold - densityLower) / double(n);
+	densityWidth = h;
+	int reset = (int) floor((densityReset - densityLower) / h);
+	densityResetCell = reset < 0 ? 0 : (reset >= int(n) ? n-1 : reset);
+	
+	// faces between the cells, and the threshold half a cell above the last one
+	densityUp.resize(n-1);
+	densityDown.resize(n-1);
+	double drift, diffusion, up, down;
+	for (uint i=0; i+1<n; ++i) {
+		getCoefficients(densityLower + (i+1)*h, drift, diffusion);
+		faceRates(drift, diffusion, h, up, down);
+		densityUp[i] = up / h;
+		densityDown[i] = down / h;
+	}
+	getCoefficients(densityThreshold, drift, diffusion);
+	faceRates(drift, diffusion, 0.5*h, up, down);
+	densityOut = up / h;
+	
+	// factorise 1 - dt/2 L for the absorbed operator
+	double c = 0.5 * densityDt;
+	densityPivots.resize(n);
+	densityFactors.resize(n);
+	for (uint i=0; i<n; ++i) {
+		double diagonal = 1.0 + c * ((i ? densityDown[i-1] : 0.0) + (i+1<n ? densityUp[i] : densityOut));
+		densityFactors[i] = i ? -c * densityUp[i-1] / densityPivots[i-1] : 0.0;
+		densityPivots[i] = diagonal - (i ? densityFactors[i] * -c * densityDown[i-1] : 0.0);
+	}
+	densityReinjection.assign(n, 0.0);
+	densityReinjection[densityResetCell] = c * densityOut;
+	solveStep(densityReinjection);
+	
+	// stationary state and interval moments, from the time spent in each cell until absorption
+	vector<double> b(n, 0.0), y, z;
+	b[densityResetCell] = 1.0;
+	solveAbsorbed(b, y);
+	solveAbsorbed(y, z);
+	densityMeanInterval = densitySecondInterval = 0.0;
+	for (uint i=0; i<n; ++i) {
+		densityMeanInterval += y[i];
+		densitySecondInterval += 2.0 * z[i];
+	}
+	densityValid = isfinite(densityMeanInterval) && densityMeanInterval > 0.0;
+	if (!densityValid) {
+		cout << "population density: the threshold is never reached" << endl;
+		densityRate = 0.0;
+		densityStationary.assign(n, 0.0);
+		return;
+	}
+	densityRate = 1.0 / densityMeanInterval;
+	densityStationary.resize(n);
+	for (uint i=0; i<n; ++i)
+		densityStationary[i] = y[i] * densityRate;
+}
+
+
+//____________________________________________________________________________
+//
+//  solvers
+//
+
+void PopulationDensity::solveAbsorbed( const vector<double> &b, vector<double> &y )
+{
+	// -L is tridiagonal with positive diagonal and negative neighbours, no pivoting needed
+	uint n = densityCells;
+	vector<double> pivots(n);
+	y = b;
+	for (uint i=0; i<n; ++i) {
+		double diagonal = (i ? densityDown[i-1] : 0.0) + (i+1<n ? densityUp[i] : densityOut);
+		if (i) {
+			double factor = -densityUp[i-1] / pivots[i-1];
+			diagonal -= factor * -densityDown[i-1];
+			y[i] -= factor * y[i-1];
+		}
+		pivots[i] = diagonal;
+	}
+	y[n-1] /= pivots[n-1];
+	for (int i=n-2; i+1; --i)
+		y[i] = (y[i] + densityDown[i] * y[i+1]) / pivots[i];
+}
+
+void PopulationDensity::solveStep( vector<double> &m )
+{
+	uint n = densityCells;
+	double c = 0.5 * densityDt;
+	for (uint i=1; i<n; ++i)
+		m[i] -= densityFactors[i] * m[i-1];
+	m[n-1] /= densityPivots[n-1];
+	for (int i=n-2; i+1; --i)
+		m[i] = (m[i] + c * densityDown[i] * m[i+1]) / densityPivots[i];
+}
+
+double PopulationDensity::step( vector<double> &m, bool reinject, bool implicit )
+{
+	uint n = densityCells;
+	double c = 0.5 * densityDt;
+	double before = m[n-1];
+	
+	// right hand side, m + dt/2 L m for Crank-Nicolson
+	vector<double> r(m);
+	if (!implicit) {
+		for (uint i=0; i<n; ++i) {
+			double flow = -(i ? densityDown[i-1] : 0.0) * m[i] - (i+1<n ? densityUp[i] : densityOut) * m[i];
+			if (i)
+				flow += densityUp[i-1] * m[i-1];
+			if (i+1<n)
+				flow += densityDown[i] * m[i+1];
+			r[i] += c * flow;
+		}
+		if (reinject)
+			r[densityResetCell] += c * densityOut * m[n-1];
+	}
+	
+	// the reinjection couples the last cell to the reset cell (Sherman-Morrison)
+	solveStep(r);
+	if (reinject) {
+		double scale = r[n-1] / (1.0 - densityReinjection[n-1]);
+		for (uint i=0; i<n; ++i)
+			r[i] += densityReinjection[i] * scale;
+	}
+	m.swap(r);
+	
+	return c * densityOut * (implicit ? m[n-1] : before + m[n-1]);
+}
+
+
+//____________________________________________________________________________
+//
+//  results
+//
+
+void PopulationDensity::setProperty( const Property &p, double d )
+{
+	if (p == EST_DIST_MIN)
+		densityRange[0] = d;
+	else if (p == EST_DIST_MAX)
+		densityRange[1] = d;
+	else if (p == EST_DIST_BINS && d > 0)
+		densityBins = (int) d;
+}
+
+Matrix PopulationDensity::getIntervals( const Property &p )
+{
+	if (!densityValid) {
+		cout << "population density: no valid model" << endl;
+		return Matrix();
+	}
+	
+	if (p & EST_MEAN) {
+		Matrix a;
+		a.setName("mean of intervals (population density)");
+		a = densityMeanInterval;
+		return a;
+	}
+	else if (p & EST_VAR) {
+		Matrix a;
+		a.setName("variance of intervals (population density)");
+		a = densitySecondInterval - densityMeanInterval * densityMeanInterval;
+		return a;
+	}
+	else if (p & EST_DENS) {
+		// bins as in ScalarEstimator, centred at min + i*scale
+		double min = densityRange[0], max = densityRange[1];
+		if (max <= min) {
+			min = 0.0;
+			max = 5.0 * densityMeanInterval;
+		}
+		double scale = (max - min) / double(densityBins);
+		double end = min + (densityBins - 0.5) * scale;
+		
+		// distribution function of the first passage from the reset, at each time step
+		uint n = densityCells;
+		vector<double> m(n, 0.0), distribution(1, 0.0);
+		m[densityResetCell] = 1.0;
+		double passed = 0.0;
+		for (uint k=0; densityDt*k < end && passed < 1.0 - 1e-12; ++k) {
+			if (k < 2)
+				passed += step(m, false, true) + step(m, false, true);
+			else
+				passed += step(m, false, false);
+			distribution.push_back(passed);
+		}
+		
+		Matrix a(densityBins, 2);
+		a.setName("probability distribution of intervals (population density)");
+		for (int i=0; i<densityBins; i++) {
+			double centre = double(i) * scale + min;
+			double bounds[2] = { centre - 0.5*scale, centre + 0.5*scale };
+			double values[2];
+			for (int j=0; j<2; ++j) {
+				double t = bounds[j] / densityDt;
+				if (t <= 0.0)
+					values[j] = 0.0;
+				else if (t >= distribution.size() - 1)
+					values[j] = distribution.back();
+				else {
+					uint k = (uint) t;
+					values[j] = distribution[k] + (t - k) * (distribution[k+1] - distribution[k]);
+				}
+			}
+			a[i][0] = centre;
+			a[i][1] = (values[1] - values[0]) / scale;
+		}
+		return a;
+	}
+	cout << "didn't find property" << endl;
+	cout << "requested: " << p << endl;
+	return Matrix();
+}
+
+Matrix PopulationDensity::getPotentials( const Property &p )
+{
+	if (!densityValid) {
+		cout << "population density: no valid model" << endl;
+		return Matrix();
+	}
+	
+	uint n = densityCells;
+	double mean = 0.0, second = 0.0;
+	for (uint i=0; i<n; ++i) {
+		double x = densityLower + (i + 0.5) * densityWidth;
+		mean += x * densityStationary[i];
+		second += x * x * densityStationary[i];
+	}
+	
+	if (p & EST_MEAN) {
+		Matrix a;
+		a.setName("mean of membrane (population density)");
+		a = mean;
+		return a;
+	}
+	else if (p & EST_VAR) {
+		Matrix a;
+		a.setName("variance of membrane (population density)");
+		a = second - mean * mean;
+		return a;
+	}
+	else if (p & EST_DENS) {
+		Matrix a(n, 2);
+		a.setName("probability distribution of membrane (population density)");
+		for (uint i=0; i<n; ++i) {
+			a[i][0] = densityLower + (i + 0.5) * densityWidth;
+			a[i][1] = densityStationary[i] / densityWidth;
+		}
+		return a;
+	}
+	cout << "didn't find property" << endl;
+	cout << "requested: " << p << endl;
+	return Matrix();
+}
+
+Matrix PopulationDensity::getTriggered( const Property &p, int pre, int post )
+{
+	if (!densityValid) {
+		cout << "population density: no valid model" << endl;
+		return Matrix();
+	}
+	if (!(p & (EST_MEAN | EST_VAR))) {
+		cout << "didn't find property" << endl;
+		cout << "requested: " << p << endl;
+		return Matrix();
+	}
+	bool variance = !(p & EST_MEAN);
+	
+	uint n = densityCells;
+	vector<double> x(n);
+	for (uint i=0; i<n; ++i)
+		x[i] = densityLower + (i + 0.5) * densityWidth;
+	
+	Graph a(pre+post+1);
+	a.setName(variance ? "conditional variance (population density)" : "conditional mean (population density)");
+	for (int i=0; i<pre+post+1; i++)
+		a[i][0] = densityDt * ((double) i - pre);
+	
+	// after the spike, the density starting at the reset
+	vector<double> m(n, 0.0);
+	m[densityResetCell] = 1.0;
+	for (int k=0; k<=post; ++k) {
+		if (k == 1 || k == 2) {
+			step(m, true, true);
+			step(m, true, true);
+		}
+		else if (k)
+			step(m, true, false);
+		double mass = 0.0, first = 0.0, second = 0.0;
+		for (uint i=0; i<n; ++i) {
+			mass += m[i];
+			first += x[i] * m[i];
+			second += x[i] * x[i] * m[i];
+		}
+		first /= mass;
+		a[pre+k][1] = variance ? second/mass - first*first : first;
+	}
+	
+	// before the spike, weighting the stationary density with the rate of spikes k steps later
+	vector<double> q0(densityStationary), q1(n), q2(n);
+	for (uint i=0; i<n; ++i) {
+		q1[i] = x[i] * densityStationary[i];
+		q2[i] = x[i] * q1[i];
+	}
+	for (int k=1; k<=pre; ++k) {
+		step(q0, true, false);
+		step(q1, true, false);
+		step(q2, true, false);
+		double first = q1[n-1] / q0[n-1];
+		a[pre-k][1] = variance ? q2[n-1]/q0[n-1] - first*first : first;
+	}
+	return a;
+}
@@ -25,6 +25,7 @@ __________________________________________________________________________
 
 #include <cstdlib>
 #include <cmath>
+#include <climits>
 #include <sstream>
 
 
@@ -175,27 +176,55 @@ double VoltageDependance::calculateNextValue()
 //  poisson process
 
 Poisson::Poisson(double rate, Time* time, const string& name, const string& type)
-	: StochasticEventGenerator(time, name, type)
+	: StochasticEventGenerator(time, name, type), RandN(time)
 {
    poissonRate = rate * xTime->dt;
+   poissonWait = 0;
    stochDescription = "Poisson process";
    addParameter("rate");
 }
 
 Poisson::Poisson(Time* time, const string& name, const string& type)
-: StochasticEventGenerator(time, name, type)
+: StochasticEventGenerator(time, name, type), RandN(time)
 {
 	poissonRate = 5.0 * xTime->dt;
+	poissonWait = 0;
 	stochDescription = "Poisson process";
 	addParameter("rate");
 }
 
+// geometric number of steps up to the next event
+static long geometricWait(double p, double u)
+{
+	if (p >= 1.0)
+		return 1;
+	if (p <= 0.0)
+		return LONG_MAX;
+	double k = floor(log(u) / log1p(-p));
+	return k < double(LONG_MAX - 1) ? long(k) + 1 : LONG_MAX;
+}
+
+void Poisson::drawWait()
+{
+	poissonEpoch = xTime->getRandomEpoch();
+	poissonWait = geometricWait(poissonRate, 1.0 - dRandE());
+}
+
+void Poisson::init()
+{
+	StochasticEventGenerator::init();
+	poissonWait = 0;
+}
+
 void Poisson::prepareNextState()
 {
 	if (!stochNextStateIsPrepared) {
-		if( dRandE() < poissonRate ) {
+		if (poissonWait == 0 || poissonEpoch != xTime->getRandomEpoch())
+			drawWait();
+		if( --poissonWait == 0 ) {
 			stochNextValue += 1.0;
             eventNextValue = true;
+			drawWait();
         }
         else
             eventNextValue = false;
@@ -222,6 +251,7 @@ void Poisson::setParameter(const string& name, const string& value)
 	if (name=="rate") {
 		parameter >> poissonRate;
 		poissonRate *= xTime->dt;
+		poissonWait = 0;
 	}
 	else
 		StochasticEventGenerator::setParameter( name, value );
@@ -229,6 +259,104 @@ void Poisson::setParameter(const string& name, const string& value)
 
 
 
+//____________________________________________________________________________
+//  inhomogeneous Poisson process
+
+InhomogeneousPoisson::InhomogeneousPoisson(Function &rate, double maxRate, Time *time, const string& name, const string& type)
+	: StochasticEventGenerator(time, name, type), RandN(time)
+{
+	inhomRate = &rate;
+	inhomIndex = 0;
+	inhomMax = maxRate * xTime->dt;
+	inhomWait = 0;
+	inhomWarned = false;
+	stochDescription = "inhomogeneous Poisson process";
+}
+
+InhomogeneousPoisson::InhomogeneousPoisson(Matrix profile, Time *time, const string& name, const string& type)
+	: StochasticEventGenerator(time, name, type), RandN(time)
+{
+	inhomRate = 0;
+	inhomIndex = 0;
+	inhomWait = 0;
+	inhomWarned = false;
+	stochDescription = "inhomogeneous Poisson process";
+	
+	// read table
+	double maxRate = 0.0;
+	if (profile.nDimension() != 2 || profile.nSize(1) < 2 || profile.nSize(0) < 1)
+		cout << "InhomogeneousPoisson: rate profile must be a nx2 matrix." << endl;
+	else
+		for (int i=0; i<profile.nSize(0); ++i) {
+			inhomTimes.push_back(profile[i][0].to_d());
+			inhomRates.push_back(profile[i][1].to_d());
+			if (inhomRates.back() > maxRate)
+				maxRate = inhomRates.back();
+		}
+	inhomMax = maxRate * xTime->dt;
+}
+
+double InhomogeneousPoisson::getRate(double t)
+{
+	if (inhomRate)
+		return (*inhomRate)(t);
+	if (inhomRates.empty())
+		return 0.0;
+	
+	// candidates come in order, so the search starts at the last entry
+	if (inhomIndex >= inhomTimes.size() || inhomTimes[inhomIndex] > t)
+		inhomIndex = 0;
+	while (inhomIndex + 1 < inhomTimes.size() && inhomTimes[inhomIndex + 1] <= t)
+		++inhomIndex;
+	if (t <= inhomTimes[inhomIndex] || inhomIndex + 1 == inhomTimes.size())
+		return inhomRates[inhomIndex];
+	double w = (t - inhomTimes[inhomIndex]) / (inhomTimes[inhomIndex + 1] - inhomTimes[inhomIndex]);
+	return inhomRates[inhomIndex] + w * (inhomRates[inhomIndex + 1] - inhomRates[inhomIndex]);
+}
+
+void InhomogeneousPoisson::drawWait()
+{
+	inhomEpoch = xTime->getRandomEpoch();
+	inhomWait = geometricWait(inhomMax, 1.0 - dRandE());
+}
+
+void InhomogeneousPoisson::init()
+{
+	StochasticEventGenerator::init();
+	inhomWait = 0;
+	inhomIndex = 0;
+}
+
+void InhomogeneousPoisson::prepareNextState()
+{
+	if (stochNextStateIsPrepared)
+		return;
+	
+	if (inhomWait == 0 || inhomEpoch != xTime->getRandomEpoch())
+		drawWait();
+	eventNextValue = false;
+	if( --inhomWait == 0 ) {
+		// thinning
+		double p = getRate(xTime->timePassed + xTime->dt) * xTime->dt;
+		double max = inhomMax < 1.0 ? inhomMax : 1.0;
+		if (p > 1.0)
+			p = 1.0;
+		if (p > max) {
+			if (!inhomWarned)
+				cout << "InhomogeneousPoisson: rate above the maximum rate " << inhomMax / xTime->dt << ", cut off." << endl;
+			inhomWarned = true;
+			p = max;
+		}
+		if (dRandE() * max < p) {
+			stochNextValue += 1.0;
+			eventNextValue = true;
+		}
+		drawWait();
+	}
+	stochNextStateIsPrepared = true;
+}
+
+
 //____________________________________________________________________________
 //  regular process
 
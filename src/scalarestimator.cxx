@@ -157,6 +157,23 @@ Matrix ScalarEstimator::getEstimate(const Property& p)
 	return Matrix();
 }
 
+void ScalarEstimator::merge(Estimator *other)
+{
+	ScalarEstimator *e = dynamic_cast<ScalarEstimator *>(other);
+	if( !e || e->nEstimate != nEstimate || e->nDist != nDist ) {
+		cout << "can't merge estimators with different properties" << endl;
+		return;
+	}
+	if( e->nSamples )
+		dSample = e->dSample;
+	nSamples += e->nSamples;
+	dOne += e->dOne;
+	dTwo += e->dTwo;
+	dThree += e->dThree;
+	for(int i=0; i<nDist; i++)
+		aDist[i] += e->aDist[i];
+}
+
 ScalarEstimator::~ScalarEstimator()
 {
 	if(nDist)
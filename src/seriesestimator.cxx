@@ -129,7 +129,7 @@ void SeriesEstimator::collect()
 			&& seriesRecords[estimatorPre] >= seriesTriggers.first()
 			&& seriesRecords[estimatorPre+1] < seriesTriggers.first())
 		{
-			uint triggerTime;   // how long ago this trigger was
+			uint triggerTime = 0;   // how long ago this trigger was
 			seriesTriggers >> triggerTime;
 			
 			if (seriesRecords.isInitialized()) {
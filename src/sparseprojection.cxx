@@ -0,0 +1,179 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#include "../h/sparseprojection.hxx"
+#include "../h/ifneuronpopulation.hxx"
+
+#include <algorithm>
+
+
+//____________________________________________________________________________
+//
+//  construct
+//
+
+SparseProjection::SparseProjection(Time *time, IfNeuronPopulation *source, IfNeuronPopulation *target, const vector<uint> &pre, const vector<uint> &post, const vector<double> &weights, const vector<double> &reversals)
+	: TimeDependent(time)
+{
+	projectionSource = source;
+	projectionTarget = target;
+	projectionNextStateIsPrepared = false;
+	build(pre, post, weights, reversals, vector<uint>(pre.size(), 0));
+	target->addInput(this);
+}
+
+SparseProjection::SparseProjection(Time *time, IfNeuronPopulation *source, IfNeuronPopulation *target, const vector<uint> &pre, const vector<uint> &post, const vector<double> &weights, double reversal)
+	: TimeDependent(time)
+{
+	projectionSource = source;
+	projectionTarget = target;
+	projectionNextStateIsPrepared = false;
+	build(pre, post, weights, vector<double>(pre.size(), reversal), vector<uint>(pre.size(), 0));
+	target->addInput(this);
+}
+
+SparseProjection::SparseProjection(Time *time, IfNeuronPopulation *source, IfNeuronPopulation *target, const vector<uint> &pre, const vector<uint> &post, const vector<double> &weights, const vector<double> &reversals, const vector<uint> &delays)
+	: TimeDependent(time)
+{
+	projectionSource = source;
+	projectionTarget = target;
+	projectionNextStateIsPrepared = false;
+	build(pre, post, weights, reversals, delays);
+	target->addInput(this);
+}
+
+void SparseProjection::build(const vector<uint> &pre, const vector<uint> &post, const vector<double> &weights, const vector<double> &reversals, const vector<uint> &delays)
+{
+	uint n = projectionSource->getSize();
+	uint edges = pre.size();
+	if (post.size() != edges || weights.size() != edges || reversals.size() != edges || delays.size() != edges) {
+		cout << "SparseProjection: edge lists differ in length, no edges made" << endl;
+		edges = 0;
+	}
+	uint maxDelay = 0;
+	for (uint e=0; e<edges; ++e) {
+		if (pre[e] >= n || post[e] >= projectionTarget->getSize()) {
+			cout << "SparseProjection: edge " << e << " out of range, no edges made" << endl;
+			edges = 0;
+			maxDelay = 0;
+			break;
+		}
+		maxDelay = max(maxDelay, delays[e]);
+	}
+	
+	// order by delay, then stable by source cell, so rows are sorted by delay
+	vector<uint> byDelay(edges), order(edges);
+	vector<uint> starts(maxDelay + 2, 0);
+	for (uint e=0; e<edges; ++e)
+		++starts[delays[e] + 1];
+	for (uint d=0; d<=maxDelay; ++d)
+		starts[d + 1] += starts[d];
+	for (uint e=0; e<edges; ++e)
+		byDelay[starts[delays[e]]++] = e;
+	
+	// count the edges of each row, the running sum gives the row starts
+	projectionRows.assign(n + 1, 0);
+	for (uint e=0; e<edges; ++e)
+		++projectionRows[pre[e] + 1];
+	for (uint i=0; i<n; ++i)
+		projectionRows[i + 1] += projectionRows[i];
+	
+	// place each edge behind the ones of its row placed before
+	projectionTargets.resize(edges);
+	projectionWeights.resize(edges);
+	projectionReversals.resize(edges);
+	projectionDelays.resize(edges);
+	vector<uint> fill(projectionRows.begin(), projectionRows.end() - 1);
+	for (uint j=0; j<edges; ++j) {
+		uint e = byDelay[j];
+		uint k = fill[pre[e]]++;
+		projectionTargets[k] = post[e];
+		projectionWeights[k] = weights[e];
+		projectionReversals[k] = reversals[e];
+		projectionDelays[k] = delays[e];
+	}
+	
+	// groups of equal delay within each row
+	projectionRowSegments.assign(n + 1, 0);
+	projectionSegments.clear();
+	projectionSegmentDelays.clear();
+	for (uint i=0; i<n; ++i) {
+		projectionRowSegments[i] = projectionSegments.size();
+		for (uint k=projectionRows[i]; k<projectionRows[i + 1]; ++k)
+			if (k == projectionRows[i] || projectionDelays[k] != projectionDelays[k - 1]) {
+				projectionSegments.push_back(k);
+				projectionSegmentDelays.push_back(projectionDelays[k]);
+			}
+	}
+	projectionRowSegments[n] = projectionSegments.size();
+	projectionSegments.push_back(edges);
+	
+	projectionCalendar.resize(maxDelay);
+}
+
+
+//____________________________________________________________________________
+//
+//  deliver spikes
+//
+
+void SparseProjection::getInputs( vector<TimeDependent *> &inputs )
+{
+	inputs.push_back(projectionSource);
+}
+
+void SparseProjection::prepareNextState()
+{
+	if (projectionNextStateIsPrepared)
+		return;
+	
+	// schedule the groups of all spiking cells
+	const vector<uint> &spikes = projectionSource->getSpikes();
+	for (uint s=0; s<spikes.size(); ++s) {
+		uint end = projectionRowSegments[spikes[s] + 1];
+		for (uint g=projectionRowSegments[spikes[s]]; g<end; ++g)
+			projectionCalendar.schedule(projectionSegmentDelays[g], g);
+	}
+	
+	// push the groups arriving now
+	const vector<uint> &due = projectionCalendar.due();
+	for (uint s=0; s<due.size(); ++s) {
+		uint end = projectionSegments[due[s] + 1];
+		for (uint k=projectionSegments[due[s]]; k<end; ++k)
+			projectionTarget->addConductance(projectionTargets[k], projectionWeights[k], projectionReversals[k]);
+	}
+	projectionNextStateIsPrepared = true;
+}
+
+void SparseProjection::proceedToNextState()
+{
+	if (projectionNextStateIsPrepared)
+		projectionCalendar.advance();
+	projectionNextStateIsPrepared = false;
+}
+
+void SparseProjection::init()
+{
+	projectionCalendar.clear();
+	projectionNextStateIsPrepared = false;
+}
@@ -23,80 +23,310 @@ __________________________________________________________________________
 
 #include "../h/stochastic.hxx"
 #include <fstream>
+#include <cstring>
 
-uint RandN::nRefs = 0;
-uint32_t RandN::nState = 0;
-mt19937_64 *RandN::randGenerator = 0;
-int RandN::nRand = 0; // index into aRand
-double RandN::aRand[2] = {0,0}; // two random variables
-boost::random::uniform_real_distribution<double> RandN::dist(0.0,1.0);
+uint64_t RandN::nDefaultSeed = 0;
+uint RandN::nDefaultStreams = 0;
 
-RandN::RandN()
+// Philox4x32-10 constants
+static const uint32_t PHILOX_M0 = 0xD2511F53;
+static const uint32_t PHILOX_M1 = 0xCD9E8D57;
+static const uint32_t PHILOX_W0 = 0x9E3779B9;
+static const uint32_t PHILOX_W1 = 0xBB67AE85;
+
+// blocks generated at once by the bulk functions
+static const uint RANDN_CHUNK = 64;
+
+//____________________________________________________________________________
+//
+//  kernels
+//
+//  All loops are free of branches and calls, so that the compiler can
+//  vectorise them (SSE2 by default, AVX2/AVX-512 with NEUROLAB_NATIVE).
+//
+
+// Philox4x32-10 of n consecutive blocks
+static void philoxBlocks(uint64_t first, uint32_t stream, uint32_t run, const uint32_t *key, uint32_t *w0, uint32_t *w1, uint32_t *w2, uint32_t *w3, uint n)
 {
-	// values for the gaussian distribution
-	RandN::nRand = 1;
-	RandN::aRand[0] = 0.0;
-	RandN::aRand[1] = 0.0;
-	
-	// creates a random number generator of type luxury2
-	// see the docu of the GSL for other possible types
-	if (!RandN::randGenerator) {
-		RandN::randGenerator = new boost::random::mt19937_64;
-		
-		// seed
-		if (!RandN::nState) {
-			ifstream devrandom("/dev/urandom");
-			if (devrandom)
-				devrandom.read((char *)&RandN::nState, sizeof(RandN::nState));
-			cout << "seeding random number generator with " << RandN::nState << endl;
-			randGenerator->seed( RandN::nState );
+	for (uint j=0; j<n; ++j) {
+		uint64_t block = first + j;
+		uint32_t c0 = uint32_t(block), c1 = uint32_t(block >> 32), c2 = stream, c3 = run;
+		uint32_t k0 = key[0], k1 = key[1];
+		for (int r=0; r<10; ++r) {
+			uint64_t p0 = uint64_t(PHILOX_M0) * c0;
+			uint64_t p1 = uint64_t(PHILOX_M1) * c2;
+			uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+			uint32_t n2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+			c1 = uint32_t(p1);
+			c3 = uint32_t(p0);
+			c0 = n0;
+			c2 = n2;
+			k0 += PHILOX_W0;
+			k1 += PHILOX_W1;
 		}
+		w0[j] = c0;
+		w1[j] = c1;
+		w2[j] = c2;
+		w3[j] = c3;
 	}
-	RandN::nRefs++;
+}
+
+// uniform value in [1,2) from 52 random bits of two words
+static inline double unitInterval(uint32_t high, uint32_t low)
+{
+	uint64_t bits = 0x3FF0000000000000ULL | (uint64_t(high) << 20) | (low >> 12);
+	double d;
+	memcpy(&d, &bits, sizeof(d));
+	return d;
+}
+
+// natural logarithm of u in (0,1]
+static inline double logUnit(double u)
+{
+	uint64_t bits;
+	memcpy(&bits, &u, sizeof(bits));
+	
+	// exponent as double, by placing it into the mantissa of 2^52
+	uint64_t exponentBits = 0x4330000000000000ULL | (bits >> 52);
+	double exponent;
+	memcpy(&exponent, &exponentBits, sizeof(exponent));
+	exponent -= 4503599627370496.0 + 1023.0;
+	
+	// mantissa in [1,2), moved to [sqrt(1/2), sqrt(2))
+	uint64_t mantissaBits = (bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;
+	double m;
+	memcpy(&m, &mantissaBits, sizeof(m));
+	bool high = m > 1.4142135623730951;
+	m = high ? 0.5 * m : m;
+	exponent = high ? exponent + 1.0 : exponent;
+	
+	// log(m) = 2 atanh(s), |s| < 0.172
+	double s = (m - 1.0) / (m + 1.0);
+	double s2 = s*s;
+	double p = 1.0/21.0;
+	p = p*s2 + 1.0/19.0;
+	p = p*s2 + 1.0/17.0;
+	p = p*s2 + 1.0/15.0;
+	p = p*s2 + 1.0/13.0;
+	p = p*s2 + 1.0/11.0;
+	p = p*s2 + 1.0/9.0;
+	p = p*s2 + 1.0/7.0;
+	p = p*s2 + 1.0/5.0;
+	p = p*s2 + 1.0/3.0;
+	p = p*s2 + 1.0;
+	return exponent * 0.6931471805599453 + 2.0 * s * p;
+}
+
+// sine and cosine of 2 pi u, u in [0,1)
+static inline void sinCosTurn(double u, double &sine, double &cosine)
+{
+	// quadrant and angle in [-pi/4, pi/4]
+	double v = 4.0 * u;
+	int q = int(v + 0.5);
+	double x = (v - double(q)) * 1.5707963267948966;
+	double x2 = x*x;
+	
+	// Taylor series, exact to double precision on [-pi/4, pi/4]
+	double s = -1.0/1307674368000.0;
+	s = s*x2 + 1.0/6227020800.0;
+	s = s*x2 - 1.0/39916800.0;
+	s = s*x2 + 1.0/362880.0;
+	s = s*x2 - 1.0/5040.0;
+	s = s*x2 + 1.0/120.0;
+	s = s*x2 - 1.0/6.0;
+	s = x + x*x2*s;
+	double c = 1.0/20922789888000.0;
+	c = c*x2 - 1.0/87178291200.0;
+	c = c*x2 + 1.0/479001600.0;
+	c = c*x2 - 1.0/3628800.0;
+	c = c*x2 + 1.0/40320.0;
+	c = c*x2 - 1.0/720.0;
+	c = c*x2 + 1.0/24.0;
+	c = c*x2 - 0.5;
+	c = 1.0 + x2*c;
+	
+	// rotate by quadrant
+	bool odd = q & 1;
+	bool negSine = q & 2; // quadrants 2 and 3
+	bool negCosine = (q + 1) & 2; // quadrants 1 and 2
+	double a = odd ? c : s;
+	double b = odd ? s : c;
+	sine = negSine ? -a : a;
+	cosine = negCosine ? -b : b;
+}
+
+
+//____________________________________________________________________________
+//
+//  RandN
+//
+
+RandN::RandN()
+{
+	randTime = 0;
+	randStream = nDefaultStreams++;
+	rekey();
+};
+
+RandN::RandN( Time *time )
+{
+	randTime = time;
+	randStream = time ? time->newStream() : nDefaultStreams++;
+	rekey();
 };
 	
 RandN::~RandN()
 {
-	RandN::nRefs--;
-	if (!RandN::nRefs && RandN::randGenerator) {
-		delete RandN::randGenerator;
-		RandN::randGenerator = 0;
+};
+
+uint64_t RandN::getDefaultSeed()
+{
+	if (!nDefaultSeed) {
+		uint32_t state = 0;
+		ifstream devrandom("/dev/urandom");
+		if (devrandom)
+			devrandom.read((char *)&state, sizeof(state));
+		cout << "seeding random number generator with " << state << endl;
+		nDefaultSeed = state ? state : 1;
 	}
-	RandN::nState = 0;
+	return nDefaultSeed;
+}
+
+void RandN::setStream( uint stream )
+{
+	randStream = stream;
+	rekey();
+}
+
+void RandN::rekey()
+{
+	uint64_t seed = randTime ? randTime->getSeed() : getDefaultSeed();
+	uint64_t run = randTime ? randTime->getRandomRun() : 0;
+	randEpoch = randTime ? randTime->getRandomEpoch() : 0;
+	randKey[0] = uint32_t(seed);
+	randKey[1] = uint32_t(seed >> 32);
+	randRun = uint32_t(run);
+	randBlockNumber = 0;
+	randBlockIndex = 2;
+	nRand = RANDN_BUFFER;
+}
+
+double RandN::dRandE()
+{
+	checkEpoch();
+	if (randBlockIndex == 2) {
+		philoxBlocks(randBlockNumber++, randStream, randRun, randKey, randBlock, randBlock+1, randBlock+2, randBlock+3, 1);
+		randBlockIndex = 0;
+	}
+	double d = unitInterval(randBlock[2*randBlockIndex], randBlock[2*randBlockIndex+1]);
+	++randBlockIndex;
+	return d - 1.0;
 };
+
+uint RandN::nRandP(double mean)
+{
+	if (mean <= 0.0)
+		return 0;
 	
- double RandN::dRandN()
- {
-	 if(!RandN::nRand)
-		 return RandN::aRand[++RandN::nRand];
-	else {
-		// Polar-Marsaglia method for normal distribution
-		double test = 2.0, u1, u2, c;
-		while(test>1.0) {
-			u1 = dRandE();
-			u2 = dRandE();
-			u1 = 2.0*u1 - 1.0;
-			u2 = 2.0*u2 - 1.0;
-			test = u1*u1 + u2*u2;
+	// inversion
+	if (mean < 10.0) {
+		double p = exp(-mean);
+		double sum = p;
+		double u = dRandE();
+		uint k = 0;
+		while (u > sum && k < 1000) {
+			++k;
+			p *= mean / k;
+			sum += p;
 		}
-		c = sqrt(-(2.0/test)*log(test));
-		RandN::aRand[0] = c*u1;
-		RandN::aRand[1] = c*u2;
+		return k;
+	}
+	
+	// transformed rejection
+	double root = sqrt(mean);
+	double logMean = log(mean);
+	double b = 0.931 + 2.53 * root;
+	double a = -0.059 + 0.02483 * b;
+	double alpha = 1.1239 + 1.1328 / (b - 3.4);
+	double vr = 0.9277 - 3.6224 / (b - 2.0);
+	while (true) {
+		double u = dRandE() - 0.5;
+		double v = dRandE();
+		double us = 0.5 - fabs(u);
+		double k = floor((2.0 * a / us + b) * u + mean + 0.43);
+		if (us >= 0.07 && v <= vr)
+			return uint(k);
+		if (k < 0.0 || (us < 0.013 && v > us))
+			continue;
+		if (log(v) + log(alpha) - log(a / (us * us) + b) <= -mean + k * logMean - lgamma(k + 1.0))
+			return uint(k);
+	}
+}
+
+void RandN::fillE(double *values, uint n)
+{
+	checkEpoch();
+	uint32_t w0[RANDN_CHUNK], w1[RANDN_CHUNK], w2[RANDN_CHUNK], w3[RANDN_CHUNK];
+	
+	// two values per block
+	for (uint done=0; done<n; ) {
+		uint blocks = (n - done + 1) / 2;
+		if (blocks > RANDN_CHUNK)
+			blocks = RANDN_CHUNK;
+		philoxBlocks(randBlockNumber, randStream, randRun, randKey, w0, w1, w2, w3, blocks);
+		randBlockNumber += blocks;
 		
-		return RandN::aRand[--RandN::nRand];
+		uint pairs = (n - done) / 2 < blocks ? (n - done) / 2 : blocks;
+		double *v = values + done;
+		for (uint j=0; j<pairs; ++j) {
+			v[2*j] = unitInterval(w0[j], w1[j]) - 1.0;
+			v[2*j+1] = unitInterval(w2[j], w3[j]) - 1.0;
+		}
+		done += 2*pairs;
+		if (pairs < blocks)
+			values[done++] = unitInterval(w0[pairs], w1[pairs]) - 1.0;
 	}
-};
+}
 
-double RandN::dRandE()
+void RandN::fillN(double *values, uint n)
 {
-	return RandN::dist(*RandN::randGenerator);
-};
+	checkEpoch();
+	uint32_t w0[RANDN_CHUNK], w1[RANDN_CHUNK], w2[RANDN_CHUNK], w3[RANDN_CHUNK];
+	double radius[RANDN_CHUNK], sine[RANDN_CHUNK], cosine[RANDN_CHUNK];
+	
+	// one Box-Muller pair per block
+	for (uint done=0; done<n; ) {
+		uint blocks = (n - done + 1) / 2;
+		if (blocks > RANDN_CHUNK)
+			blocks = RANDN_CHUNK;
+		philoxBlocks(randBlockNumber, randStream, randRun, randKey, w0, w1, w2, w3, blocks);
+		randBlockNumber += blocks;
+		
+		for (uint j=0; j<blocks; ++j) {
+			double u1 = 2.0 - unitInterval(w0[j], w1[j]); // (0,1]
+			double u2 = unitInterval(w2[j], w3[j]) - 1.0; // [0,1)
+			radius[j] = sqrt(-2.0 * logUnit(u1));
+			sinCosTurn(u2, sine[j], cosine[j]);
+		}
+		
+		uint pairs = (n - done) / 2 < blocks ? (n - done) / 2 : blocks;
+		double *v = values + done;
+		for (uint j=0; j<pairs; ++j) {
+			v[2*j] = radius[j] * cosine[j];
+			v[2*j+1] = radius[j] * sine[j];
+		}
+		done += 2*pairs;
+		if (pairs < blocks)
+			values[done++] = radius[pairs] * cosine[pairs];
+	}
+}
 
 void StochasticEventGenerator::proceedToNextState()
 {
     if (stochNextStateIsPrepared) {
         stochCurrentValue = stochNextValue;
         eventCurrentValue = eventNextValue;
+        eventCurrentOffset = eventNextOffset;
         stochNextStateIsPrepared = false;
     }
 }
@@ -48,7 +48,10 @@ SimpleSynapse::SimpleSynapse(Time *time, StochasticEventGenerator *e, double wei
 	simplePreNeuron = e;
 	simplePeakCnd = peak;
 	simpleTimeConstant = tau;
-	differential.addTerm(new Product(-1.0/simpleTimeConstant), new TimeProcess(time));
+	simpleClock = new TimeProcess(time);
+	differential.addTerm(new Product(-1.0/simpleTimeConstant), simpleClock);
+	// stepped by the synapse, so that it rests while the synapse sleeps
+	time->remove(&differential);
 	physicalUnit = Unit("m","V") * Unit("m","S") * Unit("", "s");
 	addParameter("time-constant");
 	addParameter("peak-conductance");
@@ -58,6 +61,7 @@ SimpleSynapse::SimpleSynapse(Time *time, StochasticVariable *noiseSource, double
 	: Synapse(time, 0, weight, revPot), differential(time, 0.0, 0.0)
 {
 	simplePreNeuron = 0;
+	simpleClock = 0;
 	simplePeakCnd = 0.0;
 	simpleTimeConstant = tau;
 	differential.addTerm(new Product(-1.0/simpleTimeConstant, "X(t)/tau"), new TimeProcess(time));
@@ -94,7 +98,7 @@ double Synapse::calculateNextValue()
 
 void SimpleSynapse::proceedToNextState()
 {
-	stochCurrentValue = stochNextValue;
+	StochasticFunction::proceedToNextState();
 	differential.proceedToNextState();
 }
 
@@ -109,6 +113,19 @@ void SimpleSynapse::prepareNextState()
 	}
 }
 
+void SimpleSynapse::init()
+{
+	StochasticFunction::init();
+	if (simpleClock)
+		differential.init();
+}
+
+bool SimpleSynapse::isDormant()
+{
+	return simpleClock && simplePreNeuron && !simplePreNeuron->hasEvent()
+		&& differential.getCurrentValue() == 0.0 && differential.getNextValue() == 0.0;
+}
+
 double SimpleSynapse::calculateCurrentValue()
 {
 	return dWeight * (dRevPot - stochCurrentValue) * differential.getCurrentValue();
@@ -0,0 +1,103 @@
+/* Copyright Information
+__________________________________________________________________________
+
+Copyright (C) 2005 Jacob Kanev
+
+This file is part of NeuroLab.
+
+NeuroLab is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software Foundation,
+Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+__________________________________________________________________________
+*/
+
+#include "../h/threadpool.hxx"
+
+
+//__________________________________________________________________________________________
+// start all threads
+
+ThreadPool::ThreadPool( uint threads )
+{
+	poolTask = 0;
+	poolGeneration = 0;
+	poolWaiting = 0;
+	poolStop = false;
+	for (uint i=1; i<threads; ++i)
+		poolThreads.push_back( std::thread(&ThreadPool::work, this, i) );
+}
+
+
+//__________________________________________________________________________________________
+// stop all threads
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		poolStop = true;
+	}
+	poolStart.notify_all();
+	for (uint i=0; i<poolThreads.size(); ++i)
+		poolThreads[i].join();
+}
+
+
+//__________________________________________________________________________________________
+// run a task on all workers
+
+void ThreadPool::run( ThreadTask *task )
+{
+	// wake up all threads
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		poolTask = task;
+		poolWaiting = poolThreads.size();
+		++poolGeneration;
+	}
+	poolStart.notify_all();
+	
+	// calling thread is worker 0
+	task->execute(0);
+	
+	// wait for the others
+	std::unique_lock<std::mutex> lock(poolMutex);
+	while (poolWaiting)
+		poolDone.wait(lock);
+	poolTask = 0;
+}
+
+
+//__________________________________________________________________________________________
+// worker loop
+
+void ThreadPool::work( uint worker )
+{
+	unsigned long long generation = 0;
+	std::unique_lock<std::mutex> lock(poolMutex);
+	for (;;) {
+		while (!poolStop && poolGeneration == generation)
+			poolStart.wait(lock);
+		if (poolStop)
+			return;
+		generation = poolGeneration;
+		ThreadTask *task = poolTask;
+		
+		lock.unlock();
+		task->execute(worker);
+		lock.lock();
+		
+		if (!--poolWaiting)
+			poolDone.notify_one();
+	}
+}
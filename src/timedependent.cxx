@@ -9,21 +9,129 @@
 
 #include "../h/timedependent.hxx"
 #include "../h/stochastic.hxx"
+#include "../h/threadpool.hxx"
 
+#include <map>
+#include <queue>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+
+//__________________________________________________________________________________________
+// one phase of a parallel time step
+
+class TimePhase: public ThreadTask
+{
+public:
+	Time *phaseTime;
+	bool phaseProceed; // proceeding if true, preparing otherwise
+	
+	TimePhase( Time *time, bool proceed ) { phaseTime = time; phaseProceed = proceed; };
+	
+	virtual void execute( uint worker ) {
+		if (phaseProceed) {
+			vector<TimeDependent *> &objects = phaseTime->timeProceedLists[worker];
+			for (uint i=0; i<objects.size(); ++i)
+				objects[i]->proceedToNextState();
+		}
+		else
+			phaseTime->timeWorkerSuccess[worker] = phaseTime->prepare( phaseTime->timePrepareLists[worker] );
+	};
+};
+
+
+//__________________________________________________________________________________________
+// runs of replicas, taken one by one by each worker
+
+class ReplicaTask: public ThreadTask
+{
+public:
+	Time *taskTime;
+	vector<Time *> &taskReplicas;
+	unsigned long long taskSteps;
+	unsigned long long taskRuns;
+	DataCollector *taskCollector;
+	ostream &taskLog;
+	std::atomic<unsigned long long> taskNextRun;
+	unsigned long long taskFinishedRuns;
+	unsigned long long taskFirstRun; // run number of the first run, for the random streams
+	std::mutex taskMutex; // for the master, the collector and the log
+	
+	ReplicaTask( Time *time, vector<Time *> &replicas, unsigned long long steps, unsigned long long runs, DataCollector *collector, ostream &log )
+		: taskReplicas(replicas), taskLog(log), taskNextRun(0) {
+		taskTime = time;
+		taskSteps = steps;
+		taskRuns = runs;
+		taskCollector = collector;
+		taskFinishedRuns = 0;
+		taskFirstRun = time->getRun();
+	};
+	
+	virtual void execute( uint worker ) {
+		Time *replica = taskReplicas[worker];
+		NullStream devnull;
+		vector<unsigned long long> runNumbers(1, 0);
+		for (;;) {
+			runNumbers[0] = taskNextRun++;
+			if (runNumbers[0] >= taskRuns)
+				break;
+			if (taskCollector) {
+				std::lock_guard<std::mutex> lock(taskMutex);
+				taskCollector->beforeReplicaRun(runNumbers, replica);
+			}
+			replica->setRun(taskFirstRun + runNumbers[0]);
+			replica->run(taskSteps, devnull, true, 1);
+			
+			std::lock_guard<std::mutex> lock(taskMutex);
+			taskTime->merge(replica);
+			if (taskCollector)
+				taskCollector->afterReplicaRun(runNumbers, replica);
+			++taskFinishedRuns;
+			taskLog << "\rrunning simulation: run "
+				<< taskFinishedRuns << " of " << taskRuns
+				<< "         \t"
+				<< flush;
+		}
+	};
+};
+
+
+//__________________________________________________________________________________________
+// order of proceeding, last registered first
+
+struct ProceedingOrder
+{
+	const vector<uint> &order;
+	ProceedingOrder( const vector<uint> &o ) : order(o) {};
+	bool operator()( uint a, uint b ) const { return order[a] > order[b]; };
+};
+
+
+//__________________________________________________________________________________________
+// destroy time
+
+Time::~Time()
+{
+	if (timePool)
+		delete timePool;
+}
 
 
 //__________________________________________________________________________________________
 // run multiple simulations
 
-void Time::runNested(unsigned long long events, StochasticEventGenerator *eventSource, unsigned long long maxSteps, unsigned long long runs, DataCollector *runHelper, ostream &log )
+void Time::runNested(unsigned long long events, StochasticEventGenerator *eventSource, unsigned long long maxSteps, unsigned long long runs, DataCollector *runHelper, ostream &log, uint threads )
 {
 	vector<unsigned long long> runNumbers;
 	runNumbers.push_back(0);
+	unsigned long long firstRun = timeRun;
 	for (unsigned long long r=0; r<runs; ++r) {
 		runNumbers[0] = r;
 		if (runHelper)
 			runHelper->beforeRun(runNumbers);
-		run(events, eventSource, maxSteps, log);
+		setRun(firstRun + r);
+		run(events, eventSource, maxSteps, log, true, threads);
 		if (runHelper)
 			runHelper->afterRun(runNumbers);
 	}
@@ -33,25 +141,121 @@ void Time::runNested(unsigned long long events, StochasticEventGenerator *eventS
 //__________________________________________________________________________________________
 // run multiple simulations
 
-void Time::runNested( unsigned long long steps, unsigned long long runs, DataCollector *runHelper, ostream &log )
+void Time::runNested( unsigned long long steps, unsigned long long runs, DataCollector *runHelper, ostream &log, uint threads )
 {
 	vector<unsigned long long> runNumbers;
 	runNumbers.push_back(0);
+	unsigned long long firstRun = timeRun;
 	for (unsigned long long r=0; r<runs; ++r) {
 		runNumbers[0] = r;
 		if (runHelper)
 			runHelper->beforeRun(runNumbers);
-		run(steps, log);
+		setRun(firstRun + r);
+		run(steps, log, true, threads);
 		if (runHelper)
 			runHelper->afterRun(runNumbers);
 	}
 }
 
 
+//__________________________________________________________________________________________
+// run multiple simulations on replicas
+
+void Time::runNested( unsigned long long steps, unsigned long long runs, ReplicaFactory *factory, DataCollector *runHelper, ostream &log, uint threads )
+{
+	if (threads < 1)
+		threads = 1;
+	
+	// starting note
+	log << "\rstarting simulation: " 
+			<< runs << " runs of "
+			<< steps << " steps on "
+			<< threads << " replicas.         \t"
+			<< endl;
+	
+	// build networks, the factory is only used from this thread
+	vector<Time *> replicas;
+	for (uint i=0; i<threads; ++i) {
+		replicas.push_back( factory->createReplica(i) );
+		replicas[i]->setSeed( getSeed() );
+	}
+	
+	// results of all runs are collected here
+	for (uint i=0; i<timeEstimators.size(); ++i)
+		timeEstimators[i]->init();
+	
+	ReplicaTask task(this, replicas, steps, runs, runHelper, log);
+	if (threads > 1) {
+		setThreads(threads);
+		timePool->run(&task);
+	}
+	else
+		task.execute(0);
+	log << endl;
+	setRun( getRun() + runs );
+	
+	for (uint i=0; i<threads; ++i)
+		factory->destroyReplica( replicas[i] );
+}
+
+
+//__________________________________________________________________________________________
+// objects read by an object, directly or indirectly
+
+void Time::getSubgraph( const vector<TimeDependent *> &objects, vector<TimeDependent *> &subgraph )
+{
+	// index of each object, objects outside this time are ignored
+	map<TimeDependent *, uint> index;
+	for (uint i=0; i<timeObjects.size(); ++i)
+		index[ timeObjects[i] ] = i;
+	
+	// depth-first search along the inputs
+	vector<char> reached(timeObjects.size(), 0);
+	vector<TimeDependent *> waiting(objects);
+	vector<TimeDependent *> inputs;
+	while (!waiting.empty()) {
+		TimeDependent *current = waiting.back();
+		waiting.pop_back();
+		map<TimeDependent *, uint>::iterator found = index.find(current);
+		if (found == index.end() || reached[found->second])
+			continue;
+		reached[found->second] = 1;
+		inputs.clear();
+		current->getInputs(inputs);
+		waiting.insert(waiting.end(), inputs.begin(), inputs.end());
+	}
+	
+	for (uint i=0; i<timeObjects.size(); ++i)
+		if (reached[i])
+			subgraph.push_back(timeObjects[i]);
+}
+
+
+//__________________________________________________________________________________________
+// seed of random streams
+
+unsigned long long Time::getSeed()
+{
+	return timeSeed ? timeSeed : RandN::getDefaultSeed();
+}
+
+
+//__________________________________________________________________________________________
+// merge estimators of a replica
+
+void Time::merge( Time *replica )
+{
+	if (replica->timeEstimators.size() != timeEstimators.size())
+		cout << "merging replica: " << replica->timeEstimators.size() << " estimators, expected " << timeEstimators.size() << endl;
+	for (uint i=0; i<timeEstimators.size() && i<replica->timeEstimators.size(); ++i)
+		timeEstimators[i]->merge( replica->timeEstimators[i] );
+}
+
+
 //__________________________________________________________________________________________
 // run time
 
-void Time::run(double startTime, double endTime, ostream &log, bool init)
+void Time::run(double startTime, double endTime, ostream &log, bool init, uint threads)
 {
 	timePassed = startTime;
 	// starting note
@@ -60,19 +264,24 @@ void Time::run(double startTime, double endTime, ostream &log, bool init)
 			<< "\tend time: "
 			<< endTime
 			<< endl << endl;
-	run( endTime / dt, log, init);
+	run( endTime / dt, log, init, threads);
 }
 
-void Time::run(unsigned long long steps, ostream &log, bool init)
+void Time::run(unsigned long long steps, ostream &log, bool init, uint threads)
 {
+	setThreads(threads);
+	
 	// starting note
 	log << "\rstarting simulation: " 
 			<< steps
 			<< " steps.         \t"
 			<< endl;
 	
-	// initialise time objects
+	// initialise time objects and random streams
 	if (init) {
+		wakeAll();
+		timeRandomRun = timeRun++;
+		++timeRandomEpoch;
 		for (uint i=0; i<timeObjects.size(); ++i)
 			timeObjects[i]->init();
 		for (uint i=0; i<timeEstimators.size(); ++i)
@@ -92,8 +301,7 @@ void Time::run(unsigned long long steps, ostream &log, bool init)
 			timeEstimators[i]->collect();
 
 		// advance all objects in time
-		for (int i=timeObjects.size()-1; i+1; --i)
-			timeObjects[i]->proceedToNextState();
+		proceed();
 
 		unsigned long long currentPercentage = ( s * 100ULL ) / steps;
 		if (currentPercentage != lastPercentage) {
@@ -110,8 +318,10 @@ void Time::run(unsigned long long steps, ostream &log, bool init)
 //__________________________________________________________________________________________
 // run time
 
-void Time::run(unsigned long long events, StochasticEventGenerator *eventSource, unsigned long long maxSteps, ostream &log, bool init)
+void Time::run(unsigned long long events, StochasticEventGenerator *eventSource, unsigned long long maxSteps, ostream &log, bool init, uint threads)
 {
+	setThreads(threads);
+	
 	// starting note
 	log << "\rstarting simulation: " 
 			<< events << " events from "
@@ -119,8 +329,11 @@ void Time::run(unsigned long long events, StochasticEventGenerator *eventSource,
 			<< ".         \t"
 			<< endl;
 	
-	// initialise time objects
+	// initialise time objects and random streams
 	if (init) {
+		wakeAll();
+		timeRandomRun = timeRun++;
+		++timeRandomEpoch;
 		for (uint i=0; i<timeObjects.size(); ++i)
 			timeObjects[i]->init();
 		for (uint i=0; i<timeEstimators.size(); ++i)
@@ -141,8 +354,7 @@ void Time::run(unsigned long long events, StochasticEventGenerator *eventSource,
 			timeEstimators[i]->collect();
 
 		// advance all objects in time
-		for (int i=timeObjects.size()-1; i+1; --i)
-			timeObjects[i]->proceedToNextState();
+		proceed();
 
 		// count events
 		if (eventSource->hasEvent()) {
@@ -167,6 +379,260 @@ void Time::run(unsigned long long events, StochasticEventGenerator *eventSource,
 // perform one time step
 
 bool Time::step()
+{
+	if (!timeScheduleValid)
+		buildSchedule();
+	
+	bool allObjectsUpdated = true;
+	if (timeParallel) {
+		// each worker prepares its own groups
+		TimePhase phase(this, false);
+		timePool->run(&phase);
+		for (uint i=0; i<timeWorkerSuccess.size(); ++i)
+			if (!timeWorkerSuccess[i])
+				allObjectsUpdated = false;
+	}
+	else
+		allObjectsUpdated = prepareActive();
+	
+	if (allObjectsUpdated)
+		timePassed += dt;
+	
+	return allObjectsUpdated;
+}
+
+
+//__________________________________________________________________________________________
+// advance all objects
+
+void Time::proceed()
+{
+	if (timeParallel) {
+		TimePhase phase(this, true);
+		timePool->run(&phase);
+	}
+	else
+		proceedActive();
+}
+
+
+//__________________________________________________________________________________________
+// prepare objects in the given order
+
+bool Time::prepare( vector<TimeDependent *> &objects )
+{
+	// update all objects once
+	bool allObjectsUpdated = true;
+	for (uint i=0; i<objects.size(); ++i) {
+		if (!objects[i]->isNextStatePrepared()) {
+			objects[i]->prepareNextState();
+			if (!objects[i]->isNextStatePrepared())
+				allObjectsUpdated = false;
+		}
+	}
+	
+	// some objects have undeclared or circular dependencies
+	if (!allObjectsUpdated)
+		allObjectsUpdated = resolve(objects);
+	
+	return allObjectsUpdated;
+}
+
+
+//__________________________________________________________________________________________
+// prepare the objects awake
+
+bool Time::prepareActive()
+{
+	++timeStep;
+	if (!timeActiveValid)
+		buildActive();
+	
+	// the active objects, merged with those woken on the way
+	bool allObjectsUpdated = true;
+	vector<uint> waiting;
+	uint a = 0;
+	while (a < timeActive.size() || !timeWaking.empty()) {
+		uint p;
+		if (!timeWaking.empty() && (a == timeActive.size() || timeWaking.front() < timeActive[a])) {
+			p = timeWaking.front();
+			pop_heap(timeWaking.begin(), timeWaking.end(), std::greater<uint>());
+			timeWaking.pop_back();
+		}
+		else
+			p = timeActive[a++];
+		
+		TimeDependent *object = timeSchedule[p];
+		if (!object->isNextStatePrepared()) {
+			object->prepareNextState();
+			if (!object->isNextStatePrepared()) {
+				allObjectsUpdated = false;
+				waiting.push_back(p);
+				continue;
+			}
+		}
+		settle(p, true);
+	}
+	
+	// some objects have undeclared or circular dependencies
+	if (!allObjectsUpdated) {
+		vector<TimeDependent *> objects;
+		for (uint i=0; i<waiting.size(); ++i)
+			objects.push_back( timeSchedule[ waiting[i] ] );
+		allObjectsUpdated = resolve(objects);
+		for (uint i=0; i<waiting.size(); ++i)
+			if (objects[i]->isNextStatePrepared())
+				settle(waiting[i], false);
+	}
+	
+	return allObjectsUpdated;
+}
+
+
+//__________________________________________________________________________________________
+// proceed the objects awake
+
+void Time::proceedActive()
+{
+	if (!timeActiveValid)
+		buildActive();
+	
+	for (uint i=0; i<timeActiveProceeding.size(); ++i) {
+		uint p = timeActiveProceeding[i];
+		timeSchedule[p]->proceedToNextState();
+		
+		// wake objects sleeping until this one fires, the flag of their prepared state is reset
+		if (!timeEventSleepers[p].empty() && timeEventSources[p]->hasEvent())
+			for (uint j=0; j<timeEventSleepers[p].size(); ++j)
+				if (wakeUp( timeEventSleepers[p][j] ))
+					timeSchedule[ timeEventSleepers[p][j] ]->proceedToNextState();
+	}
+}
+
+
+//__________________________________________________________________________________________
+// wake the objects sleeping on a prepared object, let it fall asleep
+
+void Time::settle( uint p, bool ahead )
+{
+	TimeDependent *object = timeSchedule[p];
+	
+	// objects behind this one are prepared in this step, the others were prepared with their current state
+	if (!timeChangeSleepers[p].empty() && object->isChanging())
+		for (uint i=0; i<timeChangeSleepers[p].size(); ++i) {
+			uint s = timeChangeSleepers[p][i];
+			if (wakeUp(s) && ahead && s > p) {
+				timeSchedule[s]->proceedToNextState();
+				timeWaking.push_back(s);
+				push_heap(timeWaking.begin(), timeWaking.end(), std::greater<uint>());
+			}
+		}
+	
+	if (timeAwakeUntil[p] >= timeStep || !object->isDormant())
+		return;
+	
+	// the first time, only learn the wakers, so that no change of this step is missed
+	if (!timeWatched[p]) {
+		vector<TimeDependent *> changes;
+		vector<StochasticEventGenerator *> events;
+		object->getWakers(changes, events);
+		for (uint i=0; i<changes.size(); ++i) {
+			map<TimeDependent *, uint>::iterator found = timePositions.find(changes[i]);
+			if (found != timePositions.end() && found->second != p)
+				timeChangeSleepers[found->second].push_back(p);
+		}
+		for (uint i=0; i<events.size(); ++i) {
+			map<TimeDependent *, uint>::iterator found = timePositions.find(events[i]);
+			if (found != timePositions.end() && found->second != p) {
+				timeEventSleepers[found->second].push_back(p);
+				timeEventSources[found->second] = events[i];
+			}
+		}
+		timeWatched[p] = true;
+		timeAwakeUntil[p] = timeStep + 1;
+		return;
+	}
+	
+	timeAsleep[p] = true;
+	timeActiveValid = false;
+}
+
+
+//__________________________________________________________________________________________
+// mark an object as awake
+
+bool Time::wakeUp( uint p )
+{
+	// a woken object stays awake in the next step, as it may read the current state of its waker
+	timeAwakeUntil[p] = timeStep + 1;
+	if (!timeAsleep[p])
+		return false;
+	
+	timeAsleep[p] = false;
+	timeWoken.push_back(p);
+	timeActiveValid = false;
+	return true;
+}
+
+
+//__________________________________________________________________________________________
+// wake an object from outside
+
+void Time::wake( TimeDependent *object )
+{
+	map<TimeDependent *, uint>::iterator found = timePositions.find(object);
+	if (found != timePositions.end() && wakeUp(found->second))
+		object->proceedToNextState();
+}
+
+
+//__________________________________________________________________________________________
+// wake all objects
+
+void Time::wakeAll()
+{
+	for (uint p=0; p<timeAsleep.size(); ++p)
+		if (timeAsleep[p]) {
+			timeSchedule[p]->proceedToNextState();
+			timeAsleep[p] = false;
+		}
+	timeAwakeUntil.assign(timeAwakeUntil.size(), 0);
+	timeActive.clear();
+	for (uint p=0; p<timeSchedule.size(); ++p)
+		timeActive.push_back(p);
+	timeWoken.clear();
+	timeWaking.clear();
+	timeActiveValid = false;
+}
+
+
+//__________________________________________________________________________________________
+// rebuild the active lists
+
+void Time::buildActive()
+{
+	// drop the sleeping objects, merge the woken ones
+	uint n = 0;
+	for (uint i=0; i<timeActive.size(); ++i)
+		if (!timeAsleep[ timeActive[i] ])
+			timeActive[n++] = timeActive[i];
+	timeActive.resize(n);
+	sort(timeWoken.begin(), timeWoken.end());
+	timeActive.insert(timeActive.end(), timeWoken.begin(), timeWoken.end());
+	inplace_merge(timeActive.begin(), timeActive.begin() + n, timeActive.end());
+	timeActive.erase( unique(timeActive.begin(), timeActive.end()), timeActive.end() );
+	timeWoken.clear();
+	
+	timeActiveProceeding = timeActive;
+	sort(timeActiveProceeding.begin(), timeActiveProceeding.end(), ProceedingOrder(timeOrder));
+	timeActiveValid = true;
+}
+
+
+//__________________________________________________________________________________________
+// update waiting objects until nothing changes any more
+
+bool Time::resolve( vector<TimeDependent *> &objects )
 {
 	// saving flags for update success
 	bool someObjectsUpdated = true;
@@ -178,14 +644,14 @@ bool Time::step()
 		allObjectsUpdated = true;
 		
 		// try to update all waiting objects
-		for (int i=timeObjects.size()-1; i+1; --i) {
-			if (!timeObjects[i]->isNextStatePrepared()) {
+		for (uint i=0; i<objects.size(); ++i) {
+			if (!objects[i]->isNextStatePrepared()) {
 				
 				// update object
-				timeObjects[i]->prepareNextState();
+				objects[i]->prepareNextState();
 				
 				// record success of updating
-				if (timeObjects[i]->isNextStatePrepared())
+				if (objects[i]->isNextStatePrepared())
 					someObjectsUpdated = true;
 				else
 					allObjectsUpdated = false;
@@ -193,13 +659,177 @@ bool Time::step()
 		}
 	}
 	
-	if (allObjectsUpdated)
-		timePassed += dt;
-	
 	return allObjectsUpdated;
 }
 
 
+//__________________________________________________________________________________________
+// order all objects by their dependencies
+
+void Time::buildSchedule()
+{
+	// sleeping objects of the former schedule must be prepared again
+	wakeAll();
+	
+	uint n = timeObjects.size();
+	
+	// index of each object, objects outside this time are ignored
+	map<TimeDependent *, uint> index;
+	for (uint i=0; i<n; ++i)
+		index[ timeObjects[i] ] = i;
+	
+	// edges from each dependency to its dependants
+	vector< vector<uint> > dependants(n);
+	vector<uint> waiting(n, 0);
+	vector<TimeDependent *> dependencies;
+	for (uint i=0; i<n; ++i) {
+		dependencies.clear();
+		timeObjects[i]->getDependencies(dependencies);
+		for (uint j=0; j<dependencies.size(); ++j) {
+			map<TimeDependent *, uint>::iterator found = index.find(dependencies[j]);
+			if (found != index.end() && found->second != i) {
+				dependants[found->second].push_back(i);
+				++waiting[i];
+			}
+		}
+	}
+	
+	// topological sort, preferring objects registered last
+	priority_queue<uint> ready;
+	for (uint i=0; i<n; ++i)
+		if (!waiting[i])
+			ready.push(i);
+	
+	vector<bool> scheduled(n, false);
+	timeSchedule.clear();
+	while (!ready.empty()) {
+		uint i = ready.top();
+		ready.pop();
+		timeSchedule.push_back( timeObjects[i] );
+		scheduled[i] = true;
+		for (uint j=0; j<dependants[i].size(); ++j)
+			if (!--waiting[ dependants[i][j] ])
+				ready.push( dependants[i][j] );
+	}
+	
+	// circular dependencies, these are left to resolve()
+	for (int i=n-1; i+1; --i)
+		if (!scheduled[i])
+			timeSchedule.push_back( timeObjects[i] );
+	
+	// all objects awake, nothing known about their wakers
+	timePositions.clear();
+	timeOrder.assign(n, 0);
+	for (uint p=0; p<n; ++p) {
+		timePositions[ timeSchedule[p] ] = p;
+		timeOrder[p] = index[ timeSchedule[p] ];
+	}
+	timeAsleep.assign(n, 0);
+	timeWatched.assign(n, 0);
+	timeAwakeUntil.assign(n, 0);
+	timeChangeSleepers.assign(n, vector<uint>());
+	timeEventSleepers.assign(n, vector<uint>());
+	timeEventSources.assign(n, 0);
+	wakeAll();
+	
+	timeScheduleValid = true;
+	buildPartitions();
+}
+
+
+//__________________________________________________________________________________________
+// distribute independent groups of objects among the workers
+
+void Time::buildPartitions()
+{
+	timeParallel = false;
+	if (timeThreads < 2)
+		return;
+	
+	uint n = timeObjects.size();
+	map<TimeDependent *, uint> index;
+	for (uint i=0; i<n; ++i)
+		index[ timeObjects[i] ] = i;
+	
+	// join objects and their dependencies into groups
+	vector<uint> group(n);
+	for (uint i=0; i<n; ++i)
+		group[i] = i;
+	vector<TimeDependent *> dependencies;
+	for (uint i=0; i<n; ++i) {
+		dependencies.clear();
+		timeObjects[i]->getDependencies(dependencies);
+		for (uint j=0; j<dependencies.size(); ++j) {
+			map<TimeDependent *, uint>::iterator found = index.find(dependencies[j]);
+			if (found == index.end())
+				continue;
+			uint a = i, b = found->second;
+			while (group[a] != a) a = group[a];
+			while (group[b] != b) b = group[b];
+			if (a != b)
+				group[max(a, b)] = min(a, b);
+		}
+	}
+	for (uint i=0; i<n; ++i)
+		while (group[i] != group[ group[i] ])
+			group[i] = group[ group[i] ];
+	
+	// size of each group
+	vector<uint> groupSize(n, 0);
+	for (uint i=0; i<n; ++i)
+		++groupSize[ group[i] ];
+	vector< pair<uint, uint> > groups; // size, root
+	for (uint i=0; i<n; ++i)
+		if (groupSize[i])
+			groups.push_back( make_pair(groupSize[i], i) );
+	if (groups.size() < 2)
+		return;
+	
+	// largest groups first, each to the worker with least objects
+	sort(groups.rbegin(), groups.rend());
+	uint workers = timePool->size();
+	vector<uint> load(workers, 0);
+	vector<uint> worker(n, 0);
+	for (uint g=0; g<groups.size(); ++g) {
+		uint w = min_element(load.begin(), load.end()) - load.begin();
+		load[w] += groups[g].first;
+		worker[ groups[g].second ] = w;
+	}
+	
+	// per worker lists in the order of the sequential step
+	timePrepareLists.assign(workers, vector<TimeDependent *>());
+	timeProceedLists.assign(workers, vector<TimeDependent *>());
+	timeWorkerSuccess.assign(workers, 1);
+	for (uint i=0; i<timeSchedule.size(); ++i)
+		timePrepareLists[ worker[ group[ index[timeSchedule[i]] ] ] ].push_back( timeSchedule[i] );
+	for (int i=n-1; i+1; --i)
+		timeProceedLists[ worker[ group[i] ] ].push_back( timeObjects[i] );
+	
+	timeParallel = true;
+}
+
+
+//__________________________________________________________________________________________
+// set number of threads
+
+void Time::setThreads( uint threads )
+{
+	if (threads < 1)
+		threads = 1;
+	if (threads == timeThreads)
+		return;
+	
+	// an idle pool is kept for later runs, it is replaced if the number of threads changes
+	if (threads > 1 && (!timePool || timePool->size() != threads)) {
+		if (timePool)
+			delete timePool;
+		timePool = new ThreadPool(threads);
+	}
+	timeThreads = threads;
+	timeScheduleValid = false;
+}
+
+
 //__________________________________________________________________________________________
 // add object to time
 
@@ -212,8 +842,10 @@ void Time::add( class TimeDependent *object )
 			found = true;
 
 	// add if not found
-	if (!found)
+	if (!found) {
 		timeObjects.push_back( object );
+		timeScheduleValid = false;
+	}
 };
 
 void Time::add( class Estimator *object )
@@ -240,9 +872,16 @@ void Time::remove( class TimeDependent *object )
 		if (timeObjects[i] == object)
 			n = i;
 
-	// remove if found
-	if (n+1)
+	// remove if found, it must not be touched when the sleeping objects are woken
+	if (n+1) {
 		timeObjects.erase( timeObjects.begin() + n );
+		timeScheduleValid = false;
+		map<TimeDependent *, uint>::iterator found = timePositions.find(object);
+		if (found != timePositions.end()) {
+			timeAsleep[found->second] = false;
+			timePositions.erase(found);
+		}
+	}
 };
 
 void Time::remove( class Estimator *object )
@@ -31,7 +31,7 @@ __________________________________________________________________________
 //
 
 Wiener::Wiener(Time *time, const string& name, const string& type)
-	: StochasticVariable( time, name, type )
+	: RandN( time ), StochasticVariable( time, name, type )
 {
 	wienerMean = 0.0;
 	wienerStdDev = 1.0;
@@ -61,6 +61,11 @@ double Wiener::getDelta()
 	return wienerDiff;
 }
 
+double Wiener::getQuadraticVariation()
+{
+	return wienerStdDev * wienerStdDev * wienerSqrtDt * wienerSqrtDt;
+}
+
 void Wiener::setMean(double d)
 {
 	wienerMean = d;